@@ -15,30 +15,36 @@
 
 #include <microtone/midi_input.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <optional>
 #include <string>
+#include <thread>
 #include <unordered_set>
 
 namespace asciiboard {
 
 using namespace ftxui;
 
+const auto SCOPE_REFRESH_INTERVAL = std::chrono::milliseconds(33);
+
 class Asciiboard::impl {
 public:
     impl() :
         _screen{ScreenInteractive::Fullscreen()},
+        _outputTap{},
         _lastOutputBuffer{},
         _activeMidiNotes{},
         _sustainedMidiNotes{},
         _sustainPedalOn{false} {}
 
-    // No allocation can take place here (called every frame)
-    void addOutputData(const microtone::AudioBuffer& data) {
-        std::copy(std::begin(data), std::end(data), std::begin(_lastOutputBuffer));
-        _screen.PostEvent(Event::Custom);
+    void setOutputTap(microtone::OutputTapReader outputTap) {
+        _outputTap = std::move(outputTap);
     }
 
     void addMidiData(int status, int note, [[maybe_unused]] int velocity) {
-        // auto midiStatus = static_cast<microtone::MidiStatusMessage>(status);
+        // Shows every channel's notes together.
+        status &= 0b11110000;
 
         if (status == 0b10010000) {
             _activeMidiNotes.insert(note);
@@ -104,6 +110,10 @@ public:
         auto scaleFactor = 0.5;
         auto graphHeight = 40;
         auto oscilloscope = Renderer([&] {
+            if (_outputTap) {
+                _outputTap->readLatest(_lastOutputBuffer.data(), _lastOutputBuffer.size());
+            }
+
             auto width = static_cast<int>(_lastOutputBuffer.size());
             auto c = Canvas(width, graphHeight);
             for (auto i = 0; i < width - 1; ++i) {
@@ -293,10 +303,23 @@ public:
             return false;
         });
 
+        // Redraw the oscilloscope at a steady rate, independent of the audio thread.
+        auto refreshing = std::atomic<bool>{true};
+        auto refreshThread = std::thread([this, &refreshing] {
+            while (refreshing.load()) {
+                std::this_thread::sleep_for(SCOPE_REFRESH_INTERVAL);
+                _screen.PostEvent(Event::Custom);
+            }
+        });
+
         _screen.Loop(eventListener);
+
+        refreshing.store(false);
+        refreshThread.join();
     }
 
     ftxui::ScreenInteractive _screen;
+    std::optional<microtone::OutputTapReader> _outputTap;
     microtone::AudioBuffer _lastOutputBuffer;
     std::unordered_set<int> _activeMidiNotes;
     std::unordered_set<int> _sustainedMidiNotes;
@@ -318,8 +341,8 @@ Asciiboard& Asciiboard::operator=(Asciiboard&& other) noexcept {
     return *this;
 }
 
-void Asciiboard::addOutputData(const microtone::AudioBuffer& data) {
-    _impl->addOutputData(data);
+void Asciiboard::setOutputTap(microtone::OutputTapReader outputTap) {
+    _impl->setOutputTap(std::move(outputTap));
 }
 
 void Asciiboard::addMidiData(int status, int note, int velocity) {
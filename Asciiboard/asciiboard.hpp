@@ -7,6 +7,7 @@
 #include <memory>
 
 #include <microtone/synthesizer/audio_buffer.hpp>
+#include <microtone/synthesizer/output_tap.hpp>
 
 namespace asciiboard {
 
@@ -23,7 +24,8 @@ public:
     ~Asciiboard();
 
     void loop(const SynthControls& initialControls, const OnControlsChangedFn& onControlsChangedFn);
-    void addOutputData(const microtone::AudioBuffer& data);
+    // The oscilloscope polls the tap from the UI thread.
+    void setOutputTap(microtone::OutputTapReader outputTap);
     void addMidiData(int status, int note, int velocity);
 
 private:
@@ -11,8 +11,9 @@
 #include <iostream>
 #include <string>
 
+// Opens the chosen port, or every port when selectedPort is -1.
 void selectPort(microtone::MidiInput& midiInput) {
-    auto selectedPort = -1;
+    auto selectedPort = -2;
     auto numPorts = midiInput.portCount();
     while (numPorts == 0) {
         std::cout << "No midi ports are available. Press <enter> to retry." << std::endl;
@@ -21,8 +22,8 @@ void selectPort(microtone::MidiInput& midiInput) {
     if (numPorts == 1) {
         selectedPort = 0;
     } else {
-        while (selectedPort < 0 || selectedPort > numPorts - 1) {
-            std::cout << fmt::format("Please choose a port between 1 and {}.", numPorts) << std::endl;
+        while (selectedPort < -1 || selectedPort > numPorts - 1) {
+            std::cout << fmt::format("Please choose a port between 1 and {}, or 0 for all of them.", numPorts) << std::endl;
             for (auto i = 0; i < numPorts; ++i) {
                 std::cout << fmt::format("{0}. {1}", i + 1, midiInput.portName(i)) << std::endl;
             }
@@ -32,11 +33,18 @@ void selectPort(microtone::MidiInput& midiInput) {
             try {
                 selectedPort = std::stoi(input) - 1;
             } catch (...) {
+                selectedPort = -2;
                 std::cout << "Enter a number." << std::endl;
             }
         }
     }
-    midiInput.openPort(selectedPort);
+    if (selectedPort == -1) {
+        for (auto port = 0; port < numPorts; ++port) {
+            midiInput.openPort(port);
+        }
+    } else {
+        midiInput.openPort(selectedPort);
+    }
 }
 
 int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
@@ -73,21 +81,17 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
         weightedWaveTables.emplace_back(squareWave, initialControls.squareWeight);
         weightedWaveTables.emplace_back(triangleWave, initialControls.triangleWeight);
 
-        // This callback is invoked on every audio frame. Don't do anything blocking here!
-        auto onOutputFn = [&asciiboard](const microtone::AudioBuffer& outputData) {
-            asciiboard.addOutputData(outputData);
-        };
-
         // Create synthesizer
-        auto synth = microtone::Synthesizer{weightedWaveTables, onOutputFn};
+        auto synth = microtone::Synthesizer{weightedWaveTables};
+        asciiboard.setOutputTap(synth.outputTap());
 
         // Listen to midi input
         auto midiInput = microtone::MidiInput();
         selectPort(midiInput);
 
         // Start midi input, update UI and synth when midi data changes
-        midiInput.start([&synth, &asciiboard](int status, int note, int velocity) {
-            synth.addMidiData(status, note, velocity);
+        midiInput.start([&synth, &asciiboard](int status, int note, int velocity, std::chrono::steady_clock::time_point timestamp) {
+            synth.addMidiData(status, note, velocity, timestamp);
             asciiboard.addMidiData(status, note, velocity);
         });
 
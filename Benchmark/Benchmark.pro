@@ -0,0 +1,64 @@
+TEMPLATE = app
+TARGET = microtone_bench
+CONFIG += \
+    console \
+    c++17
+
+CONFIG -= qt gui
+
+DEFINES += \
+    FMT_HEADER_ONLY
+
+# Tags --json results with the commit they were measured at.
+DEFINES += MICROTONE_BENCH_REVISION=\\\"$$system(git -C $$PWD rev-parse --short HEAD)\\\"
+
+macx {
+DEFINES += __MACOSX_CORE__
+}
+windows {
+DEFINES += __WINDOWS_MM__
+}
+
+HEADERS += \
+  suite.hpp
+
+SOURCES += \
+  main.cpp \
+  suite.cpp
+
+INCLUDEPATH += \
+  $$PWD \
+  $$PWD/../Microtone/include \
+  $$PWD/../vendor/fmt-8.0.1/include
+
+DEPENDPATH += \
+  $$PWD/../Microtone/include \
+  $$PWD/../vendor/fmt-8.0.1/include
+
+macx {
+LIBS += \
+    -L$$OUT_PWD/../Microtone -lMicrotone \
+    -L$$PWD/../Microtone/vendor/rtmidi-5.0.0/lib/macos -lrtmidi \
+    -L$$PWD/../Microtone/vendor/portaudio-19.7.0/lib/macos -lportaudio \
+    -framework AudioToolbox \
+    -framework Carbon \
+    -framework CoreAudio \
+    -framework CoreFoundation \
+    -framework CoreServices \
+    -framework CoreMIDI
+}
+
+win32 {
+
+#RELEASE / DEBUG
+CONFIG(debug, debug|release) {
+    DEST_DIR = debug
+} else {
+    DEST_DIR = release
+}
+
+LIBS += \
+    -L$$OUT_PWD/../Microtone/$$DEST_DIR/ -lMicrotone \
+    -L$$PWD/../Microtone/vendor/rtmidi-5.0.0/lib/windows -lrtmidi \
+    -L$$PWD/../Microtone/vendor/portaudio-19.7.0/lib/windows -lportaudio_x64
+}
@@ -0,0 +1,758 @@
+#include <microtone/audio_backend.hpp>
+#include <microtone/exception.hpp>
+#include <microtone/microtone_platform.hpp>
+#include <microtone/realtime_check.hpp>
+#include <microtone/synthesizer/audio_buffer.hpp>
+#include <microtone/synthesizer/envelope.hpp>
+#include <microtone/synthesizer/filter.hpp>
+#include <microtone/synthesizer/low_frequency_oscillator.hpp>
+#include <microtone/synthesizer/oscillator.hpp>
+#include <microtone/synthesizer/oscillator_kernel.hpp>
+#include <microtone/synthesizer/synthesizer.hpp>
+#include <microtone/synthesizer/synthesizer_voice.hpp>
+#include <microtone/synthesizer/tuning.hpp>
+#include <microtone/synthesizer/weighted_wavetable.hpp>
+
+#include <suite.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const double SAMPLE_RATE = 48000;
+const int BENCH_FRAMES = 48000 * 4;
+
+double noteToFrequencyHertz(int note) {
+    return 440.0 * std::pow(2.0, (note - 69) / 12.0);
+}
+
+std::vector<microtone::WeightedWaveTable> makeWaveTables() {
+    auto sineWave = microtone::WaveTable{};
+    auto triangleWave = microtone::WaveTable{};
+    for (auto i = 0; i < microtone::WAVETABLE_LENGTH; ++i) {
+        sineWave[i] = std::sin(2.0 * M_PI * i / microtone::WAVETABLE_LENGTH);
+        triangleWave[i] = std::asin(std::sin(2.0 * M_PI * i / microtone::WAVETABLE_LENGTH)) * (2.0 / M_PI);
+    }
+    return {{sineWave, 0.8}, {triangleWave, 0.2}};
+}
+
+// Runs fn over BENCH_FRAMES frames, one buffer at a time, and returns the cost of one voice for one sample.
+template <typename RenderFn>
+double nanosecondsPerVoiceSample(int voiceCount, RenderFn fn) {
+    auto buffer = microtone::AudioBuffer{};
+    auto start = std::chrono::steady_clock::now();
+    for (auto frame = 0; frame < BENCH_FRAMES; frame += microtone::FRAMES_PER_BUFFER) {
+        fn(buffer.data(), microtone::FRAMES_PER_BUFFER);
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return elapsed / (static_cast<double>(BENCH_FRAMES) * voiceCount);
+}
+
+// The pre-voice-bank render path: one SynthesizerVoice object per note.
+double benchVoiceObjects(const std::vector<microtone::WeightedWaveTable>& waveTables, int voiceCount) {
+    auto voices = std::vector<microtone::SynthesizerVoice>{};
+    for (auto note = 0; note < voiceCount; ++note) {
+        voices.emplace_back(noteToFrequencyHertz(note),
+                            microtone::Envelope{0.01, 0.1, 0.8, 0.01, SAMPLE_RATE},
+                            microtone::Oscillator{noteToFrequencyHertz(note), SAMPLE_RATE},
+                            microtone::LowFrequencyOscillator{0.25, SAMPLE_RATE},
+                            microtone::Filter{});
+        voices.back().setVelocity(100);
+        voices.back().triggerOn();
+    }
+
+    return nanosecondsPerVoiceSample(voiceCount, [&](float* out, int frames) {
+        std::fill(out, out + frames, 0.0f);
+        for (auto& voice : voices) {
+            voice.processBlock(waveTables, out, frames);
+        }
+    });
+}
+
+// The synthesizer's voice bank, rendered headless.
+double benchVoiceBank(const std::vector<microtone::WeightedWaveTable>& waveTables, int voiceCount) {
+    auto synth = microtone::Synthesizer{waveTables,
+                                        std::make_unique<microtone::OfflineAudioBackend>(SAMPLE_RATE)};
+    for (auto note = 0; note < voiceCount; ++note) {
+        synth.addMidiData(0b10010000, note, 100);
+    }
+
+    return nanosecondsPerVoiceSample(voiceCount, [&](float* out, int frames) {
+        synth.render(out, frames);
+    });
+}
+
+// Renders every voice the synthesizer has across renderThreads threads. Returns the output
+// and the wall-clock cost of one voice for one sample.
+std::pair<std::vector<float>, double> renderAllVoices(const std::vector<microtone::WeightedWaveTable>& waveTables, int renderThreads) {
+    const auto voiceCount = 127;
+    auto synth = microtone::Synthesizer{waveTables,
+                                        std::make_unique<microtone::OfflineAudioBackend>(SAMPLE_RATE),
+                                        renderThreads};
+    for (auto note = 0; note < voiceCount; ++note) {
+        synth.addMidiData(0b10010000, note, 100, 0);
+    }
+
+    auto output = std::vector<float>(BENCH_FRAMES);
+    auto frame = std::size_t{0};
+    auto nanoseconds = nanosecondsPerVoiceSample(voiceCount, [&](float* out, int frames) {
+        synth.render(out, frames);
+        std::copy(out, out + frames, output.begin() + frame);
+        frame += frames;
+    });
+    return {output, nanoseconds};
+}
+
+// Checks that multi-threaded renders match the audio thread alone, and reports how many
+// voices each thread count could sustain in real time.
+bool benchRenderThreads(const std::vector<microtone::WeightedWaveTable>& waveTables) {
+    const auto tolerance = 1e-4;
+    const auto realTimeNanoseconds = 1e9 / SAMPLE_RATE;
+    auto cores = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+    auto passed = true;
+
+    auto [expected, ignored] = renderAllVoices(waveTables, 1);
+
+    std::cout << fmt::format("{:>8} {:>22} {:>22} {:>22}", "threads", "ns / voice sample", "real time voices", "max error") << std::endl;
+    // Always try two threads, so the pool is exercised even on one core.
+    for (auto threads = 1; threads <= std::max(cores, 2); threads *= 2) {
+        auto [actual, nanoseconds] = renderAllVoices(waveTables, threads);
+        // Partial mixes are summed in a different order, so allow for rounding.
+        auto maxError = 0.0;
+        for (std::size_t frame = 0; frame < expected.size(); ++frame) {
+            maxError = std::max(maxError, static_cast<double>(std::abs(expected[frame] - actual[frame])));
+        }
+        passed = passed && maxError <= tolerance;
+
+        std::cout << fmt::format("{:>8} {:>22.2f} {:>22.0f} {:>22.2e}{}",
+                                 threads,
+                                 nanoseconds,
+                                 realTimeNanoseconds / nanoseconds,
+                                 maxError,
+                                 maxError <= tolerance ? "" : "  FAILED")
+                  << std::endl;
+    }
+    std::cout << std::endl;
+
+    return passed;
+}
+
+// Times every voice with vibrato, tremolo and a filter sweep at each control rate, against
+// the same voices unmodulated.
+void benchModulation(const std::vector<microtone::WeightedWaveTable>& waveTables) {
+    const auto voiceCount = 127;
+
+    auto renderModulated = [&](int controlRate) {
+        auto synth = microtone::Synthesizer{waveTables,
+                                            std::make_unique<microtone::OfflineAudioBackend>(SAMPLE_RATE)};
+        if (controlRate > 0) {
+            synth.setLfoFrequency(0, 5.0);
+            synth.setLfoFrequency(1, 0.5);
+            synth.setModulationRoutes({{microtone::ModulationSource::Lfo1, microtone::ModulationDestination::Pitch, 0.2},
+                                       {microtone::ModulationSource::Lfo1, microtone::ModulationDestination::Amplitude, 0.3},
+                                       {microtone::ModulationSource::Lfo2, microtone::ModulationDestination::FilterCutoff, 1.0}});
+            synth.setControlRate(controlRate);
+        }
+        for (auto note = 0; note < voiceCount; ++note) {
+            synth.addMidiData(0b10010000, note, 100, 0);
+        }
+        return nanosecondsPerVoiceSample(voiceCount, [&](float* out, int frames) {
+            synth.render(out, frames);
+        });
+    };
+
+    std::cout << fmt::format("{:>8} {:>22}", "control", "ns / voice sample") << std::endl;
+    std::cout << fmt::format("{:>8} {:>22.2f}", "off", renderModulated(0)) << std::endl;
+    for (auto controlRate : {1, 16, 32, 64}) {
+        std::cout << fmt::format("{:>8} {:>22.2f}", controlRate, renderModulated(controlRate)) << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+// Renders the same phase sweep through kernel and the scalar reference, block by block,
+// and returns the largest sample difference.
+double kernelError(microtone::OscillatorKernelFn kernel, const microtone::WaveTable& table) {
+    auto reference = microtone::oscillatorKernel(microtone::OscillatorKernel::Scalar);
+    auto expected = microtone::AudioBuffer{};
+    auto actual = microtone::AudioBuffer{};
+    auto maxError = 0.0;
+    for (auto note : {0, 45, 69, 100, 127}) {
+        auto increment = microtone::phaseIncrement(noteToFrequencyHertz(note), SAMPLE_RATE);
+        auto expectedPhase = microtone::OscillatorPhase{0};
+        auto actualPhase = microtone::OscillatorPhase{0};
+        for (auto frames : {1, 3, 16, 37, 512, 500, 511}) {
+            expectedPhase = reference(table.data(), expectedPhase, increment, expected.data(), frames);
+            actualPhase = kernel(table.data(), actualPhase, increment, actual.data(), frames);
+            for (auto frame = 0; frame < frames; ++frame) {
+                maxError = std::max(maxError, static_cast<double>(std::abs(expected[frame] - actual[frame])));
+            }
+        }
+    }
+    return maxError;
+}
+
+// Checks every kernel this CPU supports against the scalar reference, then times it.
+bool benchOscillatorKernels(const std::vector<microtone::WeightedWaveTable>& waveTables) {
+    const auto tolerance = 1e-4;
+    const auto& table = waveTables.front().waveTable;
+    auto passed = true;
+
+    std::cout << fmt::format("{:>8} {:>22} {:>22}", "kernel", "max error", "ns / sample") << std::endl;
+    for (auto kernelId : {microtone::OscillatorKernel::Scalar,
+                          microtone::OscillatorKernel::Sse2,
+                          microtone::OscillatorKernel::Avx2,
+                          microtone::OscillatorKernel::Avx512}) {
+        auto kernel = microtone::oscillatorKernel(kernelId);
+        auto name = microtone::oscillatorKernelName(kernelId);
+        if (!kernel) {
+            std::cout << fmt::format("{:>8} {:>22}", name, "unsupported") << std::endl;
+            continue;
+        }
+
+        auto error = kernelError(kernel, table);
+        passed = passed && error <= tolerance;
+
+        auto phase = microtone::OscillatorPhase{0};
+        auto increment = microtone::phaseIncrement(440.0, SAMPLE_RATE);
+        auto nanoseconds = nanosecondsPerVoiceSample(1, [&](float* out, int frames) {
+            phase = kernel(table.data(), phase, increment, out, frames);
+        });
+        std::cout << fmt::format("{:>8} {:>22.2e} {:>22.2f}{}", name, error, nanoseconds, error <= tolerance ? "" : "  FAILED") << std::endl;
+    }
+    std::cout << fmt::format("Selected kernel: {}", microtone::oscillatorKernelName(microtone::bestOscillatorKernel())) << std::endl
+              << std::endl;
+
+    return passed;
+}
+
+// Checks the gain of every filter mode and topology at, below and above a 1kHz cutoff.
+bool benchFilters() {
+    const auto cutoff = 1000.0;
+    const auto toleranceDecibels = 1.0;
+
+    auto gainDecibels = [&](microtone::Filter filter, double frequency) {
+        auto peak = 0.0f;
+        for (auto frame = 0; frame < static_cast<int>(SAMPLE_RATE); ++frame) {
+            auto out = filter.nextSample(static_cast<float>(std::sin(2.0 * M_PI * frequency * frame / SAMPLE_RATE)));
+            // Skip the transient.
+            if (frame > SAMPLE_RATE / 2) {
+                peak = std::max(peak, std::abs(out));
+            }
+        }
+        return 20.0 * std::log10(peak);
+    };
+
+    // Expected gains at a decade below, at and a decade above the cutoff. Past the
+    // corner, two poles fall off by 40dB a decade; near Nyquist, the digital filters
+    // fall off a little faster than analog ones.
+    struct Expectation {
+        microtone::FilterMode mode;
+        std::string name;
+        std::array<double, 3> decibels;
+    };
+    const auto expectations = {Expectation{microtone::FilterMode::LowPass, "low", {0.0, -3.0, -40.0}},
+                               Expectation{microtone::FilterMode::HighPass, "high", {-40.0, -3.0, 0.0}},
+                               Expectation{microtone::FilterMode::BandPass, "band", {-17.0, 0.0, -18.0}}};
+    auto passed = true;
+
+    std::cout << fmt::format("{:>16} {:>14} {:>14} {:>14}", "filter", "100Hz [dB]", "1kHz [dB]", "10kHz [dB]") << std::endl;
+    for (auto topology : {microtone::FilterTopology::StateVariable, microtone::FilterTopology::Biquad}) {
+        for (const auto& expectation : expectations) {
+            auto filter = microtone::Filter{expectation.mode, topology, cutoff, microtone::DEFAULT_FILTER_RESONANCE, SAMPLE_RATE};
+            auto name = fmt::format("{} {}", topology == microtone::FilterTopology::StateVariable ? "svf" : "biquad", expectation.name);
+            auto line = fmt::format("{:>16}", name);
+            auto rowPassed = true;
+            auto frequency = cutoff / 10.0;
+            for (auto expected : expectation.decibels) {
+                auto decibels = gainDecibels(filter, frequency);
+                // Far down the slope, only check that it's at least as steep.
+                rowPassed = rowPassed && (expected <= -30.0 ? decibels <= expected + toleranceDecibels
+                                                            : std::abs(decibels - expected) <= toleranceDecibels);
+                line += fmt::format(" {:>14.1f}", decibels);
+                frequency *= 10.0;
+            }
+            passed = passed && rowPassed;
+            std::cout << line << (rowPassed ? "" : "  FAILED") << std::endl;
+        }
+    }
+    std::cout << std::endl;
+
+    return passed;
+}
+
+// Plays a note through both envelope curves, block by block, releasing it and retriggering
+// it halfway through the release. Every stage has to land on its level, and no sample may
+// jump far enough from the last to click.
+bool benchEnvelopes() {
+    const auto attack = 0.01;
+    const auto sustain = 0.5;
+    const auto blockFrames = 64;
+    const auto releaseFrame = static_cast<int>(SAMPLE_RATE * 0.1);
+    const auto retriggerFrame = static_cast<int>(SAMPLE_RATE * 0.11);
+    const auto totalFrames = static_cast<int>(SAMPLE_RATE * 0.3);
+    // The steepest a 10ms attack from silence gets, with room to spare.
+    const auto maxStep = 0.01f;
+    auto passed = true;
+
+    std::cout << fmt::format("{:>12} {:>10} {:>10} {:>14} {:>14}", "envelope", "peak", "sustain", "largest step", "ns / sample") << std::endl;
+    for (auto curve : {microtone::EnvelopeCurve::Linear, microtone::EnvelopeCurve::Exponential}) {
+        auto envelope = microtone::Envelope{attack, 0.02, sustain, 0.02, curve, SAMPLE_RATE};
+        auto samples = std::vector<float>(static_cast<std::size_t>(totalFrames));
+        envelope.triggerOn();
+        for (auto start = 0; start < totalFrames; start += blockFrames) {
+            if (start == releaseFrame - releaseFrame % blockFrames) {
+                envelope.triggerOff();
+            }
+            if (start == retriggerFrame - retriggerFrame % blockFrames) {
+                envelope.triggerOn();
+            }
+            envelope.processBlock(samples.data() + start, std::min(blockFrames, totalFrames - start));
+        }
+
+        auto peak = samples[static_cast<std::size_t>(SAMPLE_RATE * attack) - 1];
+        auto held = samples[static_cast<std::size_t>(releaseFrame) - blockFrames];
+        auto largestStep = 0.0f;
+        auto previous = 0.0f;
+        for (auto sample : samples) {
+            largestStep = std::max(largestStep, std::abs(sample - previous));
+            previous = sample;
+        }
+
+        // Time a note's whole life, most of it sustaining.
+        auto timed = microtone::Envelope{envelope};
+        auto blocks = 0;
+        auto nanoseconds = nanosecondsPerVoiceSample(1, [&](float* out, int frames) {
+            if (blocks++ % 64 == 0) {
+                timed.triggerOn();
+            } else if (blocks % 64 == 48) {
+                timed.triggerOff();
+            }
+            timed.processBlock(out, frames);
+        });
+
+        auto rowPassed = peak == 1.0f && held == static_cast<float>(sustain) && largestStep <= maxStep;
+        passed = passed && rowPassed;
+        std::cout << fmt::format("{:>12} {:>10.4f} {:>10.4f} {:>14.4f} {:>14.2f}{}",
+                                 curve == microtone::EnvelopeCurve::Linear ? "linear" : "exponential",
+                                 peak,
+                                 held,
+                                 largestStep,
+                                 nanoseconds,
+                                 rowPassed ? "" : "  FAILED")
+                  << std::endl;
+    }
+    std::cout << std::endl;
+
+    return passed;
+}
+
+// Renders about a second of a single held note and counts its upward zero crossings.
+double measurePitch(microtone::Synthesizer& synth) {
+    auto buffer = microtone::AudioBuffer{};
+    auto crossings = 0;
+    auto previous = 0.0f;
+    auto frame = 0;
+    for (; frame < static_cast<int>(SAMPLE_RATE); frame += microtone::FRAMES_PER_BUFFER) {
+        synth.render(buffer.data(), microtone::FRAMES_PER_BUFFER);
+        for (auto sample : buffer) {
+            crossings += previous < 0 && sample >= 0 ? 1 : 0;
+            previous = sample;
+        }
+    }
+    return crossings * SAMPLE_RATE / frame;
+}
+
+// Checks tunings against frequencies worked out by hand, then retunes a sounding note and
+// measures its pitch from zero crossings.
+bool benchTuning(const std::vector<microtone::WeightedWaveTable>& waveTables) {
+    // A just intonation scale over a keyboard mapping that skips C sharp and puts A at 432Hz.
+    const auto scl = std::string{"! just.scl\n"
+                                 "!\n"
+                                 "5-limit just intonation\n"
+                                 " 12\n"
+                                 "!\n"
+                                 "16/15\n9/8\n6/5\n5/4\n4/3\n45/32\n3/2\n8/5\n5/3\n9/5\n15/8\n1200.0 cents\n"};
+    const auto kbm = std::string{"! skip.kbm\n12\n0\n127\n60\n69\n432.0\n12\n0\nx\n2\n3\n4\n5\n6\n7\n8\n9\n10\n11\n"};
+
+    auto justFrequency = [](double ratio) {
+        return 432.0 / (5.0 / 3.0) * ratio;
+    };
+    auto checks = std::vector<std::pair<double, double>>{};
+    auto twelve = microtone::Tuning{};
+    for (auto note = 0; note < microtone::MIDI_NOTE_COUNT; ++note) {
+        checks.emplace_back(twelve.frequency(note), noteToFrequencyHertz(note));
+    }
+    auto just = microtone::Tuning::fromScala(scl, kbm);
+    checks.emplace_back(just.frequency(60), justFrequency(1.0));
+    checks.emplace_back(just.frequency(61), 0.0);
+    checks.emplace_back(just.frequency(67), justFrequency(1.5));
+    checks.emplace_back(just.frequency(69), 432.0);
+    checks.emplace_back(just.frequency(48), justFrequency(0.5));
+    auto nineteen = microtone::Tuning::equalTemperament(19);
+    checks.emplace_back(nineteen.frequency(69 + 19), 880.0);
+
+    auto maxError = 0.0;
+    for (auto [actual, expected] : checks) {
+        maxError = std::max(maxError, std::abs(actual - expected) / std::max(expected, 1.0));
+    }
+    auto rejected = false;
+    try {
+        microtone::Tuning::fromScala("bad\n2\n3/2\n");
+    } catch (const microtone::MicrotoneException&) {
+        rejected = true;
+    }
+
+    auto synth = microtone::Synthesizer{waveTables,
+                                        std::make_unique<microtone::OfflineAudioBackend>(SAMPLE_RATE)};
+    synth.addMidiData(0b10010000, 70, 100, 0);
+    auto before = measurePitch(synth);
+    synth.setTuning(microtone::Tuning::equalTemperament(24));
+    auto after = measurePitch(synth);
+    // Note 70 is A sharp in 12-tone equal temperament, a quarter tone above A in 24.
+    auto retuned = std::abs(before - 466.2) <= 2 && std::abs(after - 452.9) <= 2;
+
+    auto passed = maxError <= 1e-9 && rejected && retuned;
+    std::cout << fmt::format("Tuning: max error {:.2e}, malformed scale {}, note 70 retuned from {:.1f}Hz to {:.1f}Hz{}",
+                             maxError,
+                             rejected ? "rejected" : "accepted",
+                             before,
+                             after,
+                             passed ? "" : "  FAILED")
+              << std::endl
+              << std::endl;
+
+    return passed;
+}
+
+// Bends an MPE note by its own channel and the master channel and checks where its pitch
+// lands, then times voices gliding on their own channels against voices holding still.
+bool benchExpression(const std::vector<microtone::WeightedWaveTable>& waveTables) {
+    auto synth = microtone::Synthesizer{waveTables,
+                                        std::make_unique<microtone::OfflineAudioBackend>(SAMPLE_RATE)};
+    synth.setMpe(true);
+    // A on channel 2, bent up a quarter of its 48 semitones, with the master channel bent
+    // fully up by 2 more.
+    synth.addMidiData(0b10010001, 69, 100, 0);
+    synth.addMidiData(0b11100001, 0, 0b1010000, 0);
+    synth.addMidiData(0b11100000, 0x7F, 0x7F, 0);
+    auto bent = measurePitch(synth);
+    auto expected = 440.0 * std::exp2((12.0 + 2.0 * 8191.0 / 8192.0) / 12.0);
+    auto bendError = std::abs(bent - expected) / expected;
+
+    // Pressure through a modulation route: full pressure on another channel doesn't touch
+    // the note.
+    synth.setModulationRoutes({{microtone::ModulationSource::Pressure, microtone::ModulationDestination::Amplitude, -1.0}});
+    synth.addMidiData(0b11010010, 127, 0, 0);
+    auto buffer = microtone::AudioBuffer{};
+    synth.render(buffer.data(), microtone::FRAMES_PER_BUFFER);
+    auto peak = [&] {
+        synth.render(buffer.data(), microtone::FRAMES_PER_BUFFER);
+        return *std::max_element(buffer.begin(), buffer.end());
+    };
+    auto untouched = peak() > 0.01f;
+    synth.addMidiData(0b11010001, 127, 0, 0);
+    synth.render(buffer.data(), microtone::FRAMES_PER_BUFFER);
+    auto silenced = peak() < 1e-3f;
+
+    // One voice per member channel, each bent every millisecond, as a controller streams a
+    // slide. Bends split blocks just like any other event.
+    const auto voiceCount = microtone::MIDI_CHANNEL_COUNT - 1;
+    auto timeVoices = [&](bool gliding) {
+        auto glider = microtone::Synthesizer{waveTables,
+                                             std::make_unique<microtone::OfflineAudioBackend>(SAMPLE_RATE)};
+        glider.setMpe(true);
+        for (auto channel = 1; channel <= voiceCount; ++channel) {
+            glider.addMidiData(0b10010000 | channel, 48 + channel, 100, 0);
+        }
+        const auto bendInterval = static_cast<int>(SAMPLE_RATE / 1000);
+        auto bend = 0;
+        return nanosecondsPerVoiceSample(voiceCount, [&](float* out, int frames) {
+            for (auto frame = 0; gliding && frame < frames; frame += bendInterval) {
+                bend = (bend + 97) % 16384;
+                for (auto channel = 1; channel <= voiceCount; ++channel) {
+                    glider.addMidiData(0b11100000 | channel, bend & 0x7F, bend >> 7, frame);
+                }
+            }
+            glider.render(out, static_cast<std::size_t>(frames));
+        });
+    };
+    auto still = timeVoices(false);
+    auto gliding = timeVoices(true);
+
+    auto passed = bendError <= 0.01 && untouched && silenced;
+    std::cout << fmt::format("Expression: bent to {:.1f}Hz of {:.1f}Hz, pressure {}, {} voices {:.2f} ns per voice sample still, {:.2f} gliding{}",
+                             bent,
+                             expected,
+                             untouched && silenced ? "follows its channel" : "leaks across channels",
+                             voiceCount,
+                             still,
+                             gliding,
+                             passed ? "" : "  FAILED")
+              << std::endl
+              << std::endl;
+
+    return passed;
+}
+
+// Routes a channel to a second part with its own tuning and voice budget, and checks each
+// channel plays its own part. Then times voices spread over every part against the same
+// number in one.
+bool benchParts(const std::vector<microtone::WeightedWaveTable>& waveTables) {
+    auto synth = microtone::Synthesizer{waveTables,
+                                        std::make_unique<microtone::OfflineAudioBackend>(SAMPLE_RATE)};
+    synth.setTuning(microtone::Tuning::equalTemperament(24), 1);
+    synth.setPolyphony(1, 1);
+    synth.setChannelPart(1, 1);
+
+    synth.addMidiData(0b10010000, 70, 100, 0);
+    auto firstPart = measurePitch(synth);
+    synth.addMidiData(0b10000000, 70, 0, 0);
+    synth.addMidiData(0b10010001, 70, 100, 0);
+    auto secondPart = measurePitch(synth);
+    auto tuned = std::abs(firstPart - 466.2) <= 2 && std::abs(secondPart - 452.9) <= 2;
+
+    // Three notes on each channel: part 0 plays all of them, part 1 only has room for one.
+    for (auto note : {60, 64, 67}) {
+        synth.addMidiData(0b10010000, note, 100, 0);
+        synth.addMidiData(0b10010001, note, 100, 0);
+    }
+    auto buffer = microtone::AudioBuffer{};
+    synth.render(buffer.data(), microtone::FRAMES_PER_BUFFER);
+    auto voices = synth.metrics().activeVoices;
+
+    auto rejected = false;
+    try {
+        synth.setChannelPart(0, microtone::MAX_PARTS);
+    } catch (const microtone::MicrotoneException&) {
+        rejected = true;
+    }
+
+    const auto voiceCount = 128;
+    auto timeParts = [&](int parts) {
+        auto multitimbral = microtone::Synthesizer{waveTables,
+                                                   std::make_unique<microtone::OfflineAudioBackend>(SAMPLE_RATE)};
+        for (auto channel = 0; channel < parts; ++channel) {
+            multitimbral.setChannelPart(channel, channel);
+        }
+        // Lets the routing take effect before the notes arrive.
+        multitimbral.render(buffer.data(), microtone::FRAMES_PER_BUFFER);
+        for (auto voice = 0; voice < voiceCount; ++voice) {
+            multitimbral.addMidiData(0b10010000 | (voice % parts), voice, 100, 0);
+        }
+        return nanosecondsPerVoiceSample(voiceCount, [&](float* out, int frames) {
+            multitimbral.render(out, static_cast<std::size_t>(frames));
+        });
+    };
+    auto onePart = timeParts(1);
+    auto everyPart = timeParts(microtone::MAX_PARTS);
+
+    auto passed = tuned && voices == 4 && rejected;
+    std::cout << fmt::format("Parts: note 70 at {:.1f}Hz on part 0 and {:.1f}Hz on part 1, {} voices for 3 + 3 notes, {} voices {:.2f} ns per voice sample in 1 part, {:.2f} over {}{}",
+                             firstPart,
+                             secondPart,
+                             voices,
+                             voiceCount,
+                             onePart,
+                             everyPart,
+                             microtone::MAX_PARTS,
+                             passed ? "" : "  FAILED")
+              << std::endl
+              << std::endl;
+
+    return passed;
+}
+
+// Renders a held note while another thread floods the synthesizer with controller
+// messages it ignores. Any block the audio path drops shows up as a difference from an
+// undisturbed render.
+bool benchMidiFlood(const std::vector<microtone::WeightedWaveTable>& waveTables) {
+    const auto blocks = 400;
+    const auto eventsPerBlock = 256;
+
+    auto renderHeldNote = [&](bool flood) {
+        auto synth = microtone::Synthesizer{waveTables,
+                                            std::make_unique<microtone::OfflineAudioBackend>(SAMPLE_RATE)};
+        // On the first frame of both renders.
+        synth.addMidiData(0b10010000, 60, 100, 0);
+
+        auto renderedBlocks = std::atomic<int>{0};
+        auto sentEvents = std::atomic<int>{0};
+        auto flooder = std::thread([&] {
+            while (flood && renderedBlocks.load() < blocks) {
+                // Stay within the event queue's capacity for each block.
+                if (sentEvents.load() < (renderedBlocks.load() + 1) * eventsPerBlock) {
+                    synth.addMidiData(0b10110000, 1, sentEvents.load() % 128);
+                    ++sentEvents;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        auto output = std::vector<float>(static_cast<std::size_t>(blocks) * microtone::FRAMES_PER_BUFFER);
+        for (auto block = 0; block < blocks; ++block) {
+            // Keep the flooder busy while rendering, even on a single core.
+            while (flood && sentEvents.load() < block * eventsPerBlock) {
+                std::this_thread::yield();
+            }
+            synth.render(output.data() + static_cast<std::size_t>(block) * microtone::FRAMES_PER_BUFFER,
+                         microtone::FRAMES_PER_BUFFER);
+            renderedBlocks.store(block + 1);
+        }
+        flooder.join();
+        return std::make_pair(output, sentEvents.load());
+    };
+
+    auto [expected, ignored] = renderHeldNote(false);
+    auto [actual, sentEvents] = renderHeldNote(true);
+    // Events split blocks, which moves where the vector kernels round, so allow for that.
+    auto maxError = 0.0;
+    for (std::size_t frame = 0; frame < expected.size(); ++frame) {
+        maxError = std::max(maxError, static_cast<double>(std::abs(expected[frame] - actual[frame])));
+    }
+    auto passed = maxError <= 1e-4;
+
+    std::cout << fmt::format("MIDI flood: {} events over {} blocks, max error {:.2e}{}",
+                             sentEvents,
+                             blocks,
+                             maxError,
+                             passed ? "" : "  FAILED")
+              << std::endl
+              << std::endl;
+
+    return passed;
+}
+
+// Renders a held note and reads it back through an output tap: first within the tap's
+// capacity, where every sample must come back, then far past it, where the oldest samples
+// must be reported as dropped and the newest still come back intact.
+bool benchOutputTap(const std::vector<microtone::WeightedWaveTable>& waveTables) {
+    auto synth = microtone::Synthesizer{waveTables,
+                                        std::make_unique<microtone::OfflineAudioBackend>(SAMPLE_RATE)};
+    auto reader = synth.outputTap();
+    synth.addMidiData(0b10010000, 60, 100, 0);
+
+    auto renderAndReadBack = [&](int blocks) {
+        auto rendered = std::vector<float>(static_cast<std::size_t>(blocks) * microtone::FRAMES_PER_BUFFER);
+        for (auto block = 0; block < blocks; ++block) {
+            synth.render(rendered.data() + static_cast<std::size_t>(block) * microtone::FRAMES_PER_BUFFER,
+                         microtone::FRAMES_PER_BUFFER);
+        }
+
+        auto droppedBefore = reader.droppedFrames();
+        auto readBack = std::vector<float>(rendered.size());
+        auto count = reader.read(readBack.data(), readBack.size());
+        auto dropped = reader.droppedFrames() - droppedBefore;
+        auto intact = count + dropped == rendered.size() &&
+                      std::equal(readBack.begin(), readBack.begin() + count, rendered.begin() + dropped);
+        return std::make_pair(intact, dropped);
+    };
+
+    auto [withinCapacity, droppedWithin] = renderAndReadBack(100);
+    auto [pastCapacity, droppedPast] = renderAndReadBack(300);
+    auto passed = withinCapacity && droppedWithin == 0 && pastCapacity && droppedPast > 0;
+
+    std::cout << fmt::format("Output tap: {} dropped within capacity, {} dropped past it{}",
+                             droppedWithin,
+                             droppedPast,
+                             passed ? "" : "  FAILED")
+              << std::endl
+              << std::endl;
+
+    return passed;
+}
+
+// Plays a chord in and out and checks the metrics account for every render, event and voice.
+bool benchMetrics(const std::vector<microtone::WeightedWaveTable>& waveTables) {
+    const auto blocks = 200;
+    const auto chordSize = 16;
+
+    auto synth = microtone::Synthesizer{waveTables,
+                                        std::make_unique<microtone::OfflineAudioBackend>(SAMPLE_RATE)};
+    auto out = microtone::AudioBuffer{};
+    for (auto block = 0; block < blocks; ++block) {
+        if (block == 0 || block == blocks / 2) {
+            for (auto note = 60; note < 60 + chordSize; ++note) {
+                synth.addMidiData(block == 0 ? 0b10010000 : 0b10000000, note, 100, 0);
+            }
+        }
+        synth.render(out.data(), out.size());
+    }
+
+    auto metrics = synth.metrics();
+    auto histogramCount = std::uint64_t{0};
+    auto slowestBucket = 0;
+    for (auto bucket = 0; bucket < microtone::RENDER_TIME_BUCKET_COUNT; ++bucket) {
+        histogramCount += metrics.renderTimeHistogram[bucket];
+        if (metrics.renderTimeHistogram[bucket] > 0) {
+            slowestBucket = bucket;
+        }
+    }
+    auto passed = metrics.renderCount == blocks && histogramCount == blocks &&
+                  metrics.eventsProcessed == 2 * chordSize && metrics.peakBlockEvents == chordSize &&
+                  metrics.peakActiveVoices == chordSize && metrics.activeVoices == 0 &&
+                  metrics.droppedEvents == 0;
+
+    std::cout << fmt::format("Metrics: {} renders under {}us against a {}us deadline, max {}us, {} missed, "
+                             "peak {} voices, {} events{}",
+                             metrics.renderCount,
+                             microtone::renderTimeBucketLimit(slowestBucket).count(),
+                             std::chrono::duration_cast<std::chrono::microseconds>(metrics.deadline).count(),
+                             std::chrono::duration_cast<std::chrono::microseconds>(metrics.maxRenderTime).count(),
+                             metrics.deadlineMisses,
+                             metrics.peakActiveVoices,
+                             metrics.eventsProcessed,
+                             passed ? "" : "  FAILED")
+              << std::endl
+              << std::endl;
+
+    return passed;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    microtone::Platform::init();
+
+    // microtone_bench --json > results.json times the DSP primitives across table counts,
+    // voice counts and buffer sizes, for comparing commits.
+    if (argc > 1 && std::string{argv[1]} == "--json") {
+        bench::writeSuiteJson(bench::runSuite(), std::cout);
+        return 0;
+    }
+
+    auto waveTables = makeWaveTables();
+
+    if (!benchOscillatorKernels(waveTables) || !benchFilters() || !benchEnvelopes() || !benchTuning(waveTables) || !benchExpression(waveTables) || !benchParts(waveTables) || !benchMidiFlood(waveTables) || !benchOutputTap(waveTables) || !benchMetrics(waveTables) ||
+        !benchRenderThreads(waveTables)) {
+        return 1;
+    }
+
+    benchModulation(waveTables);
+
+    std::cout << fmt::format("{:>8} {:>22} {:>22}", "voices", "voice objects [ns]", "voice bank [ns]") << std::endl;
+    for (auto voiceCount : {1, 8, 32, 64, 127}) {
+        auto before = benchVoiceObjects(waveTables, voiceCount);
+        auto after = benchVoiceBank(waveTables, voiceCount);
+        std::cout << fmt::format("{:>8} {:>22.2f} {:>22.2f}", voiceCount, before, after) << std::endl;
+    }
+
+    // Only counts when Microtone is built with CONFIG+=microtone_rt_check.
+    if (microtone::realtimeViolationCount() > 0) {
+        std::cout << fmt::format("{} real-time violations on the audio thread  FAILED", microtone::realtimeViolationCount()) << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,201 @@
+#include <suite.hpp>
+
+#include <microtone/audio_backend.hpp>
+#include <microtone/synthesizer/envelope.hpp>
+#include <microtone/synthesizer/filter.hpp>
+#include <microtone/synthesizer/low_frequency_oscillator.hpp>
+#include <microtone/synthesizer/oscillator.hpp>
+#include <microtone/synthesizer/oscillator_kernel.hpp>
+#include <microtone/synthesizer/synthesizer.hpp>
+#include <microtone/synthesizer/synthesizer_voice.hpp>
+#include <microtone/synthesizer/weighted_wavetable.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+
+// Set by Benchmark.pro from git.
+#ifndef MICROTONE_BENCH_REVISION
+#define MICROTONE_BENCH_REVISION "unknown"
+#endif
+
+namespace bench {
+
+namespace {
+
+const double SAMPLE_RATE = 48000;
+// Each run renders about a second of audio; the fastest of RUNS runs is kept, which is the
+// one least disturbed by the rest of the machine.
+const int SUITE_FRAMES = 48000;
+const int RUNS = 3;
+// Retriggers the envelope this often so every segment gets timed, not just the sustain.
+const int ENVELOPE_CYCLE_FRAMES = 4800;
+
+const std::vector<int> TABLE_COUNTS{1, 2, 4, 8};
+const std::vector<int> VOICE_COUNTS{1, 8, 32, 128};
+const std::vector<int> BUFFER_SIZES{32, 64, 128, 256, 512};
+
+double noteToFrequencyHertz(int note) {
+    return 440.0 * std::pow(2.0, (note - 69) / 12.0);
+}
+
+// tableCount harmonics of equal weight.
+std::vector<microtone::WeightedWaveTable> makeWaveTables(int tableCount) {
+    auto waveTables = std::vector<microtone::WeightedWaveTable>{};
+    for (auto harmonic = 1; harmonic <= tableCount; ++harmonic) {
+        auto waveTable = microtone::WaveTable{};
+        for (auto i = 0; i < microtone::WAVETABLE_LENGTH; ++i) {
+            waveTable[i] = static_cast<float>(std::sin(2.0 * M_PI * harmonic * i / microtone::WAVETABLE_LENGTH));
+        }
+        waveTables.emplace_back(waveTable, 1.0 / tableCount);
+    }
+    return waveTables;
+}
+
+// Calls fn(out, bufferFrames) until SUITE_FRAMES frames are rendered, RUNS times over, and
+// returns the fastest run's cost of one voice for one sample.
+template <typename RenderFn>
+double nanosecondsPerSample(int bufferFrames, int voiceCount, RenderFn fn) {
+    auto buffer = std::vector<float>(static_cast<std::size_t>(bufferFrames));
+    auto buffers = (SUITE_FRAMES + bufferFrames - 1) / bufferFrames;
+    auto best = std::numeric_limits<double>::max();
+    for (auto run = 0; run < RUNS; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (auto i = 0; i < buffers; ++i) {
+            fn(buffer.data(), bufferFrames);
+        }
+        best = std::min(best, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best / (static_cast<double>(buffers) * bufferFrames * voiceCount);
+}
+
+void benchOscillator(std::vector<SuiteResult>& results) {
+    for (auto tableCount : TABLE_COUNTS) {
+        auto waveTables = makeWaveTables(tableCount);
+        for (auto bufferFrames : BUFFER_SIZES) {
+            auto oscillator = microtone::Oscillator{noteToFrequencyHertz(69), SAMPLE_RATE};
+            auto nanoseconds = nanosecondsPerSample(bufferFrames, 1, [&](float* out, int frames) {
+                oscillator.processBlock(waveTables, out, frames);
+            });
+            results.push_back({"oscillator", tableCount, 0, bufferFrames, nanoseconds});
+        }
+    }
+}
+
+void benchEnvelope(std::vector<SuiteResult>& results) {
+    for (auto curve : {microtone::EnvelopeCurve::Linear, microtone::EnvelopeCurve::Exponential}) {
+        for (auto bufferFrames : BUFFER_SIZES) {
+            auto envelope = microtone::Envelope{0.01, 0.02, 0.8, 0.02, curve, SAMPLE_RATE};
+            auto cycleFrames = 0;
+            auto on = false;
+            auto nanoseconds = nanosecondsPerSample(bufferFrames, 1, [&](float* out, int frames) {
+                cycleFrames -= frames;
+                if (cycleFrames <= 0) {
+                    on ? envelope.triggerOff() : envelope.triggerOn();
+                    on = !on;
+                    cycleFrames += ENVELOPE_CYCLE_FRAMES;
+                }
+                envelope.processBlock(out, frames);
+            });
+            results.push_back({curve == microtone::EnvelopeCurve::Linear ? "envelope" : "envelope_exponential", 0, 0, bufferFrames, nanoseconds});
+        }
+    }
+}
+
+void benchFilter(std::vector<SuiteResult>& results) {
+    // Filtering the same buffer in place over and over would decay it into denormals.
+    auto noise = std::vector<float>(static_cast<std::size_t>(BUFFER_SIZES.back()));
+    auto generator = std::minstd_rand{};
+    auto distribution = std::uniform_real_distribution<float>{-1.0f, 1.0f};
+    std::generate(noise.begin(), noise.end(), [&] {
+        return distribution(generator);
+    });
+
+    for (auto bufferFrames : BUFFER_SIZES) {
+        auto filter = microtone::Filter{};
+        auto nanoseconds = nanosecondsPerSample(bufferFrames, 1, [&](float* inOut, int frames) {
+            std::copy(noise.begin(), noise.begin() + frames, inOut);
+            filter.processBlock(inOut, frames);
+        });
+        results.push_back({"filter", 0, 0, bufferFrames, nanoseconds});
+    }
+}
+
+void benchSynthesizerVoice(std::vector<SuiteResult>& results) {
+    for (auto tableCount : TABLE_COUNTS) {
+        auto waveTables = makeWaveTables(tableCount);
+        for (auto bufferFrames : BUFFER_SIZES) {
+            auto voice = microtone::SynthesizerVoice{noteToFrequencyHertz(69),
+                                                     microtone::Envelope{0.01, 0.1, 0.8, 0.01, SAMPLE_RATE},
+                                                     microtone::Oscillator{noteToFrequencyHertz(69), SAMPLE_RATE},
+                                                     microtone::LowFrequencyOscillator{0.25, SAMPLE_RATE},
+                                                     microtone::Filter{}};
+            voice.setVelocity(100);
+            voice.triggerOn();
+            auto nanoseconds = nanosecondsPerSample(bufferFrames, 1, [&](float* out, int frames) {
+                std::fill(out, out + frames, 0.0f);
+                voice.processBlock(waveTables, out, frames);
+            });
+            results.push_back({"synthesizer_voice", tableCount, 0, bufferFrames, nanoseconds});
+        }
+    }
+}
+
+// Everything render() does: events, modulation, every voice and the mix.
+void benchVoiceMix(std::vector<SuiteResult>& results) {
+    for (auto tableCount : TABLE_COUNTS) {
+        auto waveTables = makeWaveTables(tableCount);
+        for (auto voiceCount : VOICE_COUNTS) {
+            for (auto bufferFrames : BUFFER_SIZES) {
+                auto synth = microtone::Synthesizer{waveTables,
+                                                    std::make_unique<microtone::OfflineAudioBackend>(SAMPLE_RATE)};
+                synth.setPolyphony(voiceCount);
+                for (auto note = 0; note < voiceCount; ++note) {
+                    synth.addMidiData(0b10010000, note, 100, 0);
+                }
+                auto nanoseconds = nanosecondsPerSample(bufferFrames, voiceCount, [&](float* out, int frames) {
+                    synth.render(out, static_cast<std::size_t>(frames));
+                });
+                results.push_back({"voice_mix", tableCount, voiceCount, bufferFrames, nanoseconds});
+            }
+        }
+    }
+}
+
+}
+
+std::vector<SuiteResult> runSuite() {
+    auto results = std::vector<SuiteResult>{};
+    benchOscillator(results);
+    benchEnvelope(results);
+    benchFilter(results);
+    benchSynthesizerVoice(results);
+    benchVoiceMix(results);
+    return results;
+}
+
+void writeSuiteJson(const std::vector<SuiteResult>& results, std::ostream& out) {
+    out << "{\n";
+    out << fmt::format("  \"revision\": \"{}\",\n", MICROTONE_BENCH_REVISION);
+    out << fmt::format("  \"kernel\": \"{}\",\n", microtone::oscillatorKernelName(microtone::bestOscillatorKernel()));
+    out << fmt::format("  \"sampleRate\": {},\n", SAMPLE_RATE);
+    out << "  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto& result = results[i];
+        out << fmt::format("    {{\"primitive\": \"{}\", \"tables\": {}, \"voices\": {}, \"bufferFrames\": {}, \"nsPerSample\": {:.4f}}}{}\n",
+                           result.primitive,
+                           result.tables,
+                           result.voices,
+                           result.bufferFrames,
+                           result.nanosecondsPerSample,
+                           i + 1 < results.size() ? "," : "");
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+}
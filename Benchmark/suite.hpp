@@ -0,0 +1,27 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// One timed configuration of one primitive. Settings that don't apply to the primitive
+// are 0.
+struct SuiteResult {
+    std::string primitive;
+    int tables;
+    int voices;
+    int bufferFrames;
+    double nanosecondsPerSample;    // Per voice for the voice mix, best of a few runs.
+};
+
+// Times Oscillator, Envelope, Filter, SynthesizerVoice and the synthesizer's full voice mix
+// across wave table counts, voice counts and buffer sizes.
+std::vector<SuiteResult> runSuite();
+
+// Writes results as a JSON document, tagged with the revision and kernel they were measured
+// with, so runs from different commits can be diffed by a script.
+void writeSuiteJson(const std::vector<SuiteResult>& results, std::ostream& out);
+
+}
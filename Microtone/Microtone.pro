@@ -12,41 +12,83 @@ DEFINES += \
 macx {
 DEFINES += __MACOSX_CORE__
 }
+
+# Reports allocations, locks and blocking calls on the audio thread: qmake CONFIG+=microtone_rt_check
+microtone_rt_check {
+DEFINES += MICROTONE_RT_CHECK
+}
 windows {
 DEFINES += __WINDOWS_MM__
 }
 
 HEADERS += \
+    include/microtone/audio_backend.hpp \
     include/microtone/microtone_platform.hpp \
     include/microtone/exception.hpp \
     include/microtone/midi_input.hpp \
+    include/microtone/realtime_check.hpp \
     include/microtone/synthesizer/audio_buffer.hpp \
     include/microtone/synthesizer/envelope.hpp \
     include/microtone/synthesizer/filter.hpp \
     include/microtone/synthesizer/low_frequency_oscillator.hpp \
+    include/microtone/synthesizer/metrics.hpp \
+    include/microtone/synthesizer/modulation.hpp \
     include/microtone/synthesizer/oscillator.hpp \
+    include/microtone/synthesizer/oscillator_kernel.hpp \
+    include/microtone/synthesizer/output_tap.hpp \
+    include/microtone/synthesizer/polyphony.hpp \
     include/microtone/synthesizer/synthesizer.hpp \
     include/microtone/synthesizer/synthesizer_voice.hpp \
+    include/microtone/synthesizer/tuning.hpp \
     include/microtone/synthesizer/wavetable.hpp \
     include/microtone/synthesizer/weighted_wavetable.hpp
 
 HEADERS += \
-    src/log.hpp
+    src/log.hpp \
+    src/midi_parser.hpp \
+    src/synthesizer/band_limited_wavetable.hpp \
+    src/synthesizer/envelope_generator.hpp \
+    src/synthesizer/event_queue.hpp \
+    src/synthesizer/filter_bank.hpp \
+    src/synthesizer/metrics_recorder.hpp \
+    src/synthesizer/output_tap.hpp \
+    src/synthesizer/patch.hpp \
+    src/synthesizer/pitch_bend.hpp \
+    src/synthesizer/render_pool.hpp \
+    src/synthesizer/snapshot.hpp \
+    src/synthesizer/tuning_table.hpp \
+    src/synthesizer/voice_allocator.hpp \
+    src/synthesizer/voice_bank.hpp
 
 SOURCES += \
+    src/audio_backend.cpp \
     src/microtone_platform.cpp \
     src/exception.cpp \
     src/log.cpp \
     src/midi_input.cpp \
+    src/midi_parser.cpp \
+    src/realtime_check.cpp \
+    src/synthesizer/band_limited_wavetable.cpp \
     src/synthesizer/envelope.cpp \
+    src/synthesizer/envelope_generator.cpp \
     src/synthesizer/filter.cpp \
+    src/synthesizer/filter_bank.cpp \
     src/synthesizer/low_frequency_oscillator.cpp \
+    src/synthesizer/metrics_recorder.cpp \
     src/synthesizer/oscillator.cpp \
+    src/synthesizer/oscillator_kernel.cpp \
+    src/synthesizer/output_tap.cpp \
+    src/synthesizer/pitch_bend.cpp \
+    src/synthesizer/render_pool.cpp \
     src/synthesizer/synthesizer.cpp \
-    src/synthesizer/synthesizer_voice.cpp
+    src/synthesizer/synthesizer_voice.cpp \
+    src/synthesizer/tuning.cpp \
+    src/synthesizer/voice_allocator.cpp \
+    src/synthesizer/voice_bank.cpp
 
 INCLUDEPATH += \
     $$PWD/include \
+    $$PWD/src \
     $$PWD/../vendor/fmt-8.0.1/include \
     $$PWD/vendor/portaudio-19.7.0/include \
     $$PWD/vendor/rtmidi-5.0.0/include \
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <microtone/microtone_platform.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace microtone {
+
+// Fills a mono buffer of the given number of frames. Called on the audio thread.
+using AudioCallbackFn = std::function<void(float* out, std::size_t frames)>;
+
+// What the device reports about the stream since it was opened.
+struct AudioBackendStats {
+    std::uint64_t underflows{0};
+    std::uint64_t overflows{0};
+    double cpuLoad{0};
+};
+
+class AudioBackend {
+public:
+    AudioBackend() = default;
+    AudioBackend(const AudioBackend&) = delete;
+    AudioBackend& operator=(const AudioBackend&) = delete;
+    virtual ~AudioBackend() = default;
+
+    virtual double sampleRate() const = 0;
+    virtual void open(AudioCallbackFn audioCallbackFn) = 0;
+    virtual void start() = 0;
+    virtual void stop() = 0;
+    // Safe to call from any thread while the stream runs.
+    virtual AudioBackendStats stats() const = 0;
+    // Whether render() is paced by a device clock. Offline rendering runs as fast as it
+    // can, so wall-clock timestamps don't say where an event belongs in it.
+    virtual bool isRealtime() const = 0;
+};
+
+// Streams to the default output device through PortAudio.
+class PortAudioBackend : public AudioBackend {
+public:
+    PortAudioBackend();
+    ~PortAudioBackend() override;
+
+    double sampleRate() const override;
+    void open(AudioCallbackFn audioCallbackFn) override;
+    void start() override;
+    void stop() override;
+    AudioBackendStats stats() const override;
+    bool isRealtime() const override;
+
+private:
+    class impl;
+    std::unique_ptr<impl> _impl;
+};
+
+// Has no device and no audio thread: the host pulls audio with Synthesizer::render(),
+// as fast as the CPU allows.
+class OfflineAudioBackend : public AudioBackend {
+public:
+    explicit OfflineAudioBackend(double sampleRate = 48000);
+    ~OfflineAudioBackend() override;
+
+    double sampleRate() const override;
+    void open(AudioCallbackFn audioCallbackFn) override;
+    void start() override;
+    void stop() override;
+    AudioBackendStats stats() const override;
+    bool isRealtime() const override;
+
+private:
+    double _sampleRate;
+};
+
+}
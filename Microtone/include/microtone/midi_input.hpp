@@ -2,6 +2,7 @@
 
 #include <microtone/microtone_platform.hpp>
 
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <string>
@@ -9,13 +10,23 @@
 
 namespace microtone {
 
+const int MIDI_NOTE_COUNT = 128;
+const int MIDI_CHANNEL_COUNT = 16;
+
+// The top nibble of a channel message's status byte; the bottom nibble is the channel.
 enum class MidiStatusMessage {
     NoteOn = 0b10010000,
     NoteOff = 0b10000000,
-    ControlChange = 0b10110000
+    ControlChange = 0b10110000,
+    ChannelPressure = 0b11010000,
+    PitchBend = 0b11100000
 };
 
-using OnMidiDataFn = std::function<void(int status, int note, int velocity)>;
+// Called for each channel message, on the MIDI driver's thread, as soon as the message
+// arrives; timestamp is that arrival time. Calls for different ports never overlap.
+// Messages with a single data byte pass a velocity of 0. It shouldn't block, since the next
+// message waits on it.
+using OnMidiDataFn = std::function<void(int status, int note, int velocity, std::chrono::steady_clock::time_point timestamp)>;
 
 class MidiInput {
 public:
@@ -28,8 +39,12 @@ public:
 
     int portCount() const;
     std::string portName(int portNumber) const;
+    // Can be called for several ports, whose messages are merged into one stream.
     void openPort(int portNumber);
+    // Listens on the open ports until stop(). There's no polling thread: the drivers' threads
+    // parse messages and calls onReceivedDataFn directly.
     void start(OnMidiDataFn onReceivedDataFn);
+    // Once it returns, onReceivedDataFn won't be called again.
     void stop();
 
 private:
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+namespace microtone {
+
+// Real-time safety checking for debug builds, compiled in with `qmake CONFIG+=microtone_rt_check`
+// (MICROTONE_RT_CHECK). While a RealtimeScope is alive, every heap allocation, mutex lock or
+// blocking system call made on its thread is reported on stderr with a stack trace.
+// Synthesizer::render() and the render pool's workers open one, so any backend is covered.
+// Without MICROTONE_RT_CHECK, a scope does nothing.
+//
+// Allocations are caught on every platform. Locks and blocking calls are caught on Linux
+// only, where the C library can be interposed.
+class RealtimeScope {
+public:
+    RealtimeScope();
+    RealtimeScope(const RealtimeScope&) = delete;
+    RealtimeScope& operator=(const RealtimeScope&) = delete;
+    ~RealtimeScope();
+};
+
+// Violations reported so far, so tests can fail on them. Always 0 without MICROTONE_RT_CHECK.
+std::size_t realtimeViolationCount();
+
+}
@@ -14,29 +14,43 @@ enum class EnvelopeState {
     Off
 };
 
+enum class EnvelopeCurve {
+    Linear = 0,
+    Exponential         // Attacks rise fast and ease into full level; decays and releases fall fast and tail off.
+};
+
+// Attack, decay, sustain, release. Each stage is a segment worked out when it starts, so
+// rendering is a multiply and an add per sample, and a single fill while it holds still.
 class Envelope {
 public:
+    // Linear.
     Envelope(double attack, double decay, double sustain, double release, double sampleRate);
+    Envelope(double attack, double decay, double sustain, double release, EnvelopeCurve curve, double sampleRate);
     Envelope(const Envelope&);
     Envelope& operator=(const Envelope&) noexcept;
     Envelope(Envelope&&) noexcept;
     Envelope& operator=(Envelope&&) noexcept;
     ~Envelope();
 
-    EnvelopeState state();
-    double attack();
-    double decay();
-    double sustain();
-    double release();
+    EnvelopeState state() const;
+    double attack() const;
+    double decay() const;
+    double sustain() const;
+    double release() const;
+    EnvelopeCurve curve() const;
 
     void setAttack(double attack);
     void setDecay(double decay);
     void setSustain(double sustain);
     void setRelease(double release);
+    // Takes effect from the next stage.
+    void setCurve(EnvelopeCurve curve);
 
+    // Attacks from the current level, so retriggering doesn't click.
     void triggerOn();
     void triggerOff();
     float nextSample();
+    void processBlock(float* out, int frames);
 
 private:
     class impl;
@@ -6,16 +6,46 @@
 
 namespace microtone {
 
+enum class FilterMode {
+    LowPass = 0,
+    HighPass,
+    BandPass        // Unity gain at the cutoff.
+};
+
+enum class FilterTopology {
+    StateVariable = 0,      // Trapezoidal state variable filter, stays stable under fast cutoff sweeps.
+    Biquad                  // Transposed direct form II, with cookbook coefficients.
+};
+
+const double DEFAULT_FILTER_CUTOFF = 5000.0;
+// Q. 0.707 is as flat as a two pole filter gets; higher rings at the cutoff.
+const double DEFAULT_FILTER_RESONANCE = 0.707;
+
+// A 12dB/octave filter. Coefficients are worked out when the parameters change, never per
+// sample.
 class Filter {
 public:
+    // A state variable low-pass at DEFAULT_FILTER_CUTOFF, for 48kHz.
     Filter();
+    Filter(FilterMode mode, FilterTopology topology, double cutoff, double resonance, double sampleRate);
     Filter(const Filter&);
     Filter(Filter&&) noexcept;
     Filter& operator=(const Filter&) noexcept;
     Filter& operator=(Filter&&) noexcept;
     ~Filter();
 
+    FilterMode mode() const;
+    FilterTopology topology() const;
+    // In hertz, kept below the Nyquist frequency.
+    double cutoff() const;
+    double resonance() const;
+
+    void setCutoff(double cutoff);
+    void setResonance(double resonance);
+
     float nextSample(float in);
+    // Filters the block in place.
+    void processBlock(float* inOut, int frames);
 
 private:
     class impl;
@@ -6,7 +6,8 @@
 
 namespace microtone {
 
-// This class is a wrapper around Oscillator that manages a sinusoidal wavetable.
+// A sine oscillator meant for modulation. It reads its own wavetable, so advancing it
+// never allocates.
 
 class LowFrequencyOscillator {
 public:
@@ -17,6 +18,13 @@ public:
     LowFrequencyOscillator& operator=(LowFrequencyOscillator&&) noexcept;
     ~LowFrequencyOscillator();
 
+    void setFrequency(double frequency);
+
+    // The current value, between -1 and 1.
+    float value() const;
+    // Moves the phase on by frames samples at once, for control rate updates.
+    void advance(int frames);
+
     float nextSample();
 
 private:
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace microtone {
+
+// Render times are bucketed by powers of two microseconds: bucket 0 counts renders under
+// 2us, bucket i those in [2^i, 2^(i+1))us, and the last bucket everything slower.
+const int RENDER_TIME_BUCKET_COUNT = 20;
+
+// A copy of the synthesizer's counters at the time of the call. Counts are totals since the
+// synthesizer was created, so diff two copies for rates. Each field is read atomically, but
+// the audio thread may update others in between.
+struct SynthesizerMetrics {
+    std::array<std::uint64_t, RENDER_TIME_BUCKET_COUNT> renderTimeHistogram{};
+    std::chrono::nanoseconds lastRenderTime{0};
+    std::chrono::nanoseconds maxRenderTime{0};
+    // How long the last render() call's frames take to play, the time it had to finish in.
+    std::chrono::nanoseconds deadline{0};
+    std::uint64_t renderCount{0};
+    std::uint64_t deadlineMisses{0};    // render() calls that took longer than their deadline.
+
+    // Reported by the audio backend. All zero for backends without a device.
+    std::uint64_t underflows{0};        // Gaps in the output because a callback came back late.
+    std::uint64_t overflows{0};
+    double cpuLoad{0};                  // Share of the callback period spent rendering, 0 to 1.
+
+    int activeVoices{0};
+    int peakActiveVoices{0};
+
+    std::uint64_t eventsProcessed{0};
+    int lastBlockEvents{0};             // Events applied by the last render() call.
+    int peakBlockEvents{0};
+    std::uint64_t droppedEvents{0};     // Events lost to a full event queue.
+};
+
+// The render time a histogram bucket counts up to, for labelling it.
+std::chrono::microseconds renderTimeBucketLimit(int bucket);
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+namespace microtone {
+
+const int LFO_COUNT = 2;
+const int MAX_MODULATION_ROUTES = 8;
+// Modulation is evaluated once every this many frames and interpolated in between.
+const int DEFAULT_CONTROL_RATE = 32;
+
+// Semitones a full pitch bend moves a note. MIDI Polyphonic Expression (MPE) controllers
+// expect 48 on the channels that carry single notes and 2 on the zone's master channel.
+const double DEFAULT_PITCH_BEND_RANGE = 2;
+const double DEFAULT_MPE_PITCH_BEND_RANGE = 48;
+// The master channel of the MPE lower zone, MIDI channel 1. Channels above it carry one
+// note each.
+const int MPE_MASTER_CHANNEL = 0;
+
+enum class ModulationSource {
+    Lfo1 = 0,       // Sine, -1 to 1, shared by every voice.
+    Lfo2,
+    Envelope,       // The voice's own envelope, 0 to 1.
+    Pressure,       // Channel pressure on the voice's channel, 0 to 1.
+    Timbre          // CC74 on the voice's channel, 0 to 1, resting at 0.5.
+};
+
+enum class ModulationDestination {
+    Pitch = 0,      // depth in semitones.
+    Amplitude,      // depth as a fraction of the voice's gain.
+    FilterCutoff    // depth in octaves of the filter's cutoff.
+};
+
+struct ModulationRoute {
+    ModulationSource source;
+    ModulationDestination destination;
+    double depth;
+};
+
+}
@@ -18,6 +18,7 @@ public:
     ~Oscillator();
 
     float nextSample(const std::vector<WeightedWaveTable>& weightedWaveTables);
+    void processBlock(const std::vector<WeightedWaveTable>& weightedWaveTables, float* out, int frames);
 
 private:
     class impl;
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <microtone/microtone_platform.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace microtone {
+
+enum class OscillatorKernel {
+    Scalar = 0,
+    Sse2,
+    Avx2,
+    Avx512
+};
+
+// How far through a cycle of the wave table an oscillator is, in 32-bit fixed point. The top
+// bits index the table and the rest interpolate between neighbouring samples; overflowing
+// wraps around to the start of the table.
+using OscillatorPhase = std::uint32_t;
+
+// The increment that plays frequency at sampleRate, held below Nyquist. Work it out once per
+// note or pitch change, not per sample.
+OscillatorPhase phaseIncrement(double frequency, double sampleRate);
+
+// Fills out with frames samples of table, linearly interpolated, starting at phase and
+// advancing by increment each sample. Returns the phase following the block.
+using OscillatorKernelFn = OscillatorPhase (*)(const float* table, OscillatorPhase phase, OscillatorPhase increment, float* out, int frames);
+
+// Returns nullptr when the kernel isn't supported by this CPU or build.
+OscillatorKernelFn oscillatorKernel(OscillatorKernel kernel);
+
+// The widest kernel this CPU supports, detected once at runtime.
+OscillatorKernel bestOscillatorKernel();
+
+std::string oscillatorKernelName(OscillatorKernel kernel);
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <microtone/microtone_platform.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace microtone {
+
+class OutputTap;
+
+// Reads the synthesizer's output from the ring buffer the audio thread writes into. Every
+// reader keeps its own position, so a scope, meters and a recorder can each read at their
+// own pace without the audio thread ever waiting on them. A reader that falls further
+// behind than the ring holds loses the oldest samples and counts them as dropped.
+class OutputTapReader {
+public:
+    explicit OutputTapReader(std::shared_ptr<const OutputTap> tap);
+    OutputTapReader(const OutputTapReader&) = delete;
+    OutputTapReader& operator=(const OutputTapReader&) = delete;
+    OutputTapReader(OutputTapReader&&) noexcept;
+    OutputTapReader& operator=(OutputTapReader&&) noexcept;
+    ~OutputTapReader();
+
+    // Copies up to frames unread samples, oldest first, and returns how many were copied.
+    std::size_t read(float* out, std::size_t frames);
+    // Skips ahead and copies up to the newest frames samples, for displays that only care
+    // about now. Skipped samples don't count as dropped.
+    std::size_t readLatest(float* out, std::size_t frames);
+
+    // Samples lost to overruns since the reader was created.
+    std::uint64_t droppedFrames() const;
+
+private:
+    class impl;
+    std::unique_ptr<impl> _impl;
+};
+
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+namespace microtone {
+
+const int MAX_POLYPHONY = 256;
+const int DEFAULT_POLYPHONY = 128;
+
+// Which sounding voice a note takes over once every voice is in use.
+enum class VoiceStealingPolicy {
+    Oldest = 0,         // The voice that started first.
+    Quietest,           // The voice with the lowest output level.
+    ReleasedFirst       // The voice released longest ago, else the oldest.
+};
+
+}
@@ -1,22 +1,38 @@
 #pragma once
 
+#include <microtone/audio_backend.hpp>
 #include <microtone/microtone_platform.hpp>
+#include <microtone/midi_input.hpp>
 #include <microtone/synthesizer/audio_buffer.hpp>
 #include <microtone/synthesizer/envelope.hpp>
 #include <microtone/synthesizer/filter.hpp>
+#include <microtone/synthesizer/metrics.hpp>
+#include <microtone/synthesizer/modulation.hpp>
+#include <microtone/synthesizer/output_tap.hpp>
+#include <microtone/synthesizer/polyphony.hpp>
+#include <microtone/synthesizer/tuning.hpp>
 #include <microtone/synthesizer/weighted_wavetable.hpp>
 
 #include <array>
+#include <chrono>
+#include <cstddef>
 #include <functional>
 #include <memory>
 
 namespace microtone {
 
-using OnOutputFn = std::function<void(const AudioBuffer&)>;
+// A part is an independent instrument with its own sound and voices, played from the MIDI
+// channels routed to it. All of them render together in each pass of the one engine.
+const int MAX_PARTS = MIDI_CHANNEL_COUNT;
 
+// Every sound setting below applies to one part, part 0 unless given.
 class Synthesizer {
 public:
-    Synthesizer(const std::vector<WeightedWaveTable>&, OnOutputFn);
+    explicit Synthesizer(const std::vector<WeightedWaveTable>&);
+    Synthesizer(const std::vector<WeightedWaveTable>&, std::unique_ptr<AudioBackend>);
+    // Spreads voice rendering over renderThreads threads, counting the audio thread, each
+    // pinned to its own core. 1 renders everything on the audio thread.
+    Synthesizer(const std::vector<WeightedWaveTable>&, std::unique_ptr<AudioBackend>, int renderThreads);
     Synthesizer(const Synthesizer&) = delete;
     Synthesizer& operator=(const Synthesizer&) = delete;
     Synthesizer(Synthesizer&&) noexcept;
@@ -26,12 +42,59 @@ public:
     void start();
     void stop();
 
-    std::vector<WeightedWaveTable> weightedWaveTables() const;
-    void setWaveTables(const std::vector<WeightedWaveTable>& tables);
-    void setEnvelope(const Envelope& envelope);
-    void setFilter(const Filter& filter);
+    // Every part starts out with these wave tables.
+    std::vector<WeightedWaveTable> weightedWaveTables(int part = 0) const;
+    void setWaveTables(const std::vector<WeightedWaveTable>& tables, int part = 0);
+    // Defaults to 12-tone equal temperament. Notes already sounding slide to the new tuning
+    // at the next block; notes it leaves unmapped don't sound.
+    void setTuning(const Tuning& tuning, int part = 0);
+    void setEnvelope(const Envelope& envelope, int part = 0);
+    // Every voice gets a filter with these settings; its sample rate is ignored. Cutoff
+    // changes glide over a few milliseconds rather than jump.
+    void setFilter(const Filter& filter, int part = 0);
+    // How many voices can sound at once in the part, between 1 and MAX_POLYPHONY. Defaults
+    // to DEFAULT_POLYPHONY.
+    void setPolyphony(int polyphony, int part = 0);
+    // Defaults to VoiceStealingPolicy::ReleasedFirst.
+    void setVoiceStealingPolicy(VoiceStealingPolicy policy, int part = 0);
+    // lfo is 0 for ModulationSource::Lfo1 and 1 for ModulationSource::Lfo2.
+    void setLfoFrequency(int lfo, double frequency, int part = 0);
+    // Replaces every route, at most MAX_MODULATION_ROUTES. Routes to the same destination add up.
+    void setModulationRoutes(const std::vector<ModulationRoute>& routes, int part = 0);
+    // Frames between modulation updates, clamped to [1, FRAMES_PER_BUFFER]. Defaults to
+    // DEFAULT_CONTROL_RATE.
+    void setControlRate(int frames, int part = 0);
+    // Pitch bend, channel pressure and CC74 (timbre) apply to the notes on the channel they
+    // arrive on; pressure and timbre as the Pressure and Timbre modulation sources. A full
+    // bend moves notes by semitones. Defaults to DEFAULT_PITCH_BEND_RANGE.
+    void setPitchBendRange(double semitones, int part = 0);
+    // With MPE on, MPE_MASTER_CHANNEL's bend moves every note by the pitch bend range, and
+    // each other channel's bend moves its own note by notePitchBendRange on top. Off by
+    // default.
+    void setMpe(bool enabled, double notePitchBendRange = DEFAULT_MPE_PITCH_BEND_RANGE, int part = 0);
+    // Plays channel, 0 to MIDI_CHANNEL_COUNT - 1, on part from the next block. Notes held on
+    // the channel are released. Every channel plays part 0 by default.
+    void setChannelPart(int channel, int part);
 
+    // Renders mono audio into out. Backends call this from their audio thread; with an
+    // OfflineAudioBackend the host calls it directly.
+    void render(float* out, std::size_t frames);
+
+    // A new reader of everything rendered from now on. Take one per consumer (scope, meters,
+    // recorder) and poll it from any thread.
+    OutputTapReader outputTap() const;
+
+    // Lock-free, so it can be polled from any thread as often as needed.
+    SynthesizerMetrics metrics() const;
+
+    // Timestamps the message on arrival. With an offline backend, which has no clock to go
+    // by, the message lands on the first frame of the next render() call instead.
     void addMidiData(int status, int note, int velocity);
+    // Schedules the message at the frame matching when it was received.
+    void addMidiData(int status, int note, int velocity, std::chrono::steady_clock::time_point timestamp);
+    // Schedules the message frame frames into the next render() call, or on its last frame
+    // if the call is shorter. Offline hosts use this to render the same way every time.
+    void addMidiData(int status, int note, int velocity, int frame);
     double sampleRate();
 
     std::vector<WeightedWaveTable>& getWaveTables() const;
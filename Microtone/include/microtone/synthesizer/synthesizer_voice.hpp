@@ -34,6 +34,8 @@ public:
     void triggerOn();
     void triggerOff();
     float nextSample(const std::vector<WeightedWaveTable>& weightedWaveTables);
+    // Adds this voice's output to out.
+    void processBlock(const std::vector<WeightedWaveTable>& weightedWaveTables, float* out, int frames);
 
 private:
     class impl;
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <microtone/microtone_platform.hpp>
+#include <microtone/midi_input.hpp>
+
+#include <memory>
+#include <string>
+
+namespace microtone {
+
+// The frequency of every MIDI note. Built from Scala scale (.scl) and keyboard mapping (.kbm)
+// files, or as an equal division of the octave. Without a keyboard mapping, notes map
+// linearly onto the scale with middle C (note 60) on its first degree and A (note 69) at
+// 440Hz, as Scala does.
+class Tuning {
+public:
+    // 12-tone equal temperament.
+    Tuning();
+    Tuning(const Tuning&);
+    Tuning(Tuning&&) noexcept;
+    Tuning& operator=(const Tuning&);
+    Tuning& operator=(Tuning&&) noexcept;
+    ~Tuning();
+
+    // divisions equal steps to the octave.
+    static Tuning equalTemperament(int divisions);
+    // Parses the contents of a scale file, and of a keyboard mapping file unless kbm is
+    // empty. Throws MicrotoneException on malformed input.
+    static Tuning fromScala(const std::string& scl, const std::string& kbm = {});
+    // Reads and parses the files. An empty kbmPath maps the keyboard linearly.
+    static Tuning fromScalaFiles(const std::string& sclPath, const std::string& kbmPath = {});
+
+    // The scale file's description line.
+    std::string description() const;
+    // In hertz for notes 0 to MIDI_NOTE_COUNT - 1, or 0 for notes the keyboard mapping
+    // leaves unmapped, which don't sound.
+    double frequency(int note) const;
+
+private:
+    class impl;
+    explicit Tuning(std::unique_ptr<impl> impl);
+    std::unique_ptr<impl> _impl;
+};
+
+}
@@ -0,0 +1,213 @@
+#include <microtone/audio_backend.hpp>
+#include <microtone/exception.hpp>
+#include <microtone/log.hpp>
+#include <microtone/synthesizer/audio_buffer.hpp>
+
+#include <portaudio/portaudio.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace microtone {
+
+class PortAudioBackend::impl {
+public:
+    impl() :
+        _portAudioStream{nullptr},
+        _outputParameters{},
+        _sampleRate{0},
+        _monoBuffer{},
+        _underflows{0},
+        _overflows{0} {
+        // Initialize portaudio
+        auto portAudioInitResult = Pa_Initialize();
+        if (portAudioInitResult != paNoError) {
+            throw MicrotoneException(fmt::format("PortAudio error: {}, '{}'.",
+                                                 portAudioInitResult,
+                                                 Pa_GetErrorText(portAudioInitResult)));
+        }
+
+        auto deviceId = Pa_GetDefaultOutputDevice();
+        _outputParameters.device = deviceId;
+        if (_outputParameters.device == paNoDevice) {
+            Pa_Terminate();
+            throw MicrotoneException(fmt::format("Unable to open output device {}.", deviceId));
+        }
+
+        const auto deviceInfo = Pa_GetDeviceInfo(deviceId);
+        if (deviceInfo) {
+            M_INFO("Opened output device '{}'.", deviceInfo->name);
+        } else {
+            Pa_Terminate();
+            throw MicrotoneException(fmt::format("Unable to collect info on output device {}.", deviceId));
+        }
+
+        _sampleRate = deviceInfo->defaultSampleRate;
+
+        _outputParameters.channelCount = CHANNEL_COUNT;
+        _outputParameters.sampleFormat = paFloat32;
+        _outputParameters.suggestedLatency = deviceInfo->defaultLowOutputLatency;
+        _outputParameters.hostApiSpecificStreamInfo = nullptr;
+    }
+
+    ~impl() {
+        if (_portAudioStream) {
+            Pa_StopStream(_portAudioStream);
+            Pa_CloseStream(_portAudioStream);
+        }
+        Pa_Terminate();
+    }
+
+    void open(AudioCallbackFn audioCallbackFn) {
+        _audioCallbackFn = std::move(audioCallbackFn);
+
+        PaError openStreamResult = Pa_OpenStream(
+            &_portAudioStream,
+            nullptr,
+            &_outputParameters,
+            _sampleRate,
+            FRAMES_PER_BUFFER,
+            paClipOff,
+            &impl::paCallback,
+            this);
+
+        if (openStreamResult != paNoError) {
+            throw MicrotoneException(fmt::format("PortAudio error: {}, '{}'.",
+                                                 openStreamResult,
+                                                 Pa_GetErrorText(openStreamResult)));
+        }
+    }
+
+    void start() {
+        auto startStreamResult = Pa_StartStream(_portAudioStream);
+        if (startStreamResult != paNoError) {
+            throw MicrotoneException(fmt::format("PortAudio error: {}, '{}'.",
+                                                 startStreamResult,
+                                                 Pa_GetErrorText(startStreamResult)));
+        }
+    }
+
+    void stop() {
+        auto stopStreamResult = Pa_StopStream(_portAudioStream);
+        if (stopStreamResult != paNoError) {
+            throw MicrotoneException(fmt::format("PortAudio error: {}, '{}'.",
+                                                 stopStreamResult,
+                                                 Pa_GetErrorText(stopStreamResult)));
+        }
+    }
+
+    AudioBackendStats stats() const {
+        auto stats = AudioBackendStats{};
+        stats.underflows = _underflows.load(std::memory_order_relaxed);
+        stats.overflows = _overflows.load(std::memory_order_relaxed);
+        stats.cpuLoad = _portAudioStream ? Pa_GetStreamCpuLoad(_portAudioStream) : 0.0;
+        return stats;
+    }
+
+    /* This routine will be called by the PortAudio engine when audio is needed.
+       It may called at interrupt level on some machines so don't do anything
+       that could mess up the system like calling malloc() or free().
+    */
+    static int paCallback([[maybe_unused]] const void* inputBuffer,
+                          void* outputBuffer,
+                          unsigned long framesPerBuffer,
+                          [[maybe_unused]] const PaStreamCallbackTimeInfo* timeInfo,
+                          PaStreamCallbackFlags statusFlags,
+                          void* userData) {
+        auto data = static_cast<impl*>(userData);
+        auto out = static_cast<float*>(outputBuffer);
+
+        // Only this thread writes these, so plain stores will do.
+        if (statusFlags & (paOutputUnderflow | paInputUnderflow)) {
+            data->_underflows.store(data->_underflows.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        if (statusFlags & (paOutputOverflow | paInputOverflow)) {
+            data->_overflows.store(data->_overflows.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        // The synthesizer renders mono; fan it out to every output channel.
+        auto remaining = static_cast<std::size_t>(framesPerBuffer);
+        while (remaining > 0) {
+            auto frames = std::min(remaining, data->_monoBuffer.size());
+            data->_audioCallbackFn(data->_monoBuffer.data(), frames);
+
+            for (std::size_t frame = 0; frame < frames; ++frame) {
+                for (auto channel = 0; channel < CHANNEL_COUNT; ++channel) {
+                    *out++ = data->_monoBuffer[frame];
+                }
+            }
+            remaining -= frames;
+        }
+
+        return paContinue;
+    }
+
+    static constexpr int CHANNEL_COUNT = 2;
+
+    PaStream* _portAudioStream;    // Owned by port audio, cleaned up by Pa_Terminate().
+    PaStreamParameters _outputParameters;
+    double _sampleRate;
+    AudioCallbackFn _audioCallbackFn;
+    AudioBuffer _monoBuffer;
+    std::atomic<std::uint64_t> _underflows;    // Callbacks PortAudio flagged, not frames.
+    std::atomic<std::uint64_t> _overflows;
+};
+
+PortAudioBackend::PortAudioBackend() :
+    _impl{new impl{}} {
+}
+
+PortAudioBackend::~PortAudioBackend() = default;
+
+double PortAudioBackend::sampleRate() const {
+    return _impl->_sampleRate;
+}
+
+void PortAudioBackend::open(AudioCallbackFn audioCallbackFn) {
+    _impl->open(std::move(audioCallbackFn));
+}
+
+void PortAudioBackend::start() {
+    _impl->start();
+}
+
+void PortAudioBackend::stop() {
+    _impl->stop();
+}
+
+AudioBackendStats PortAudioBackend::stats() const {
+    return _impl->stats();
+}
+
+bool PortAudioBackend::isRealtime() const {
+    return true;
+}
+
+OfflineAudioBackend::OfflineAudioBackend(double sampleRate) :
+    _sampleRate{sampleRate} {
+}
+
+OfflineAudioBackend::~OfflineAudioBackend() = default;
+
+double OfflineAudioBackend::sampleRate() const {
+    return _sampleRate;
+}
+
+void OfflineAudioBackend::open([[maybe_unused]] AudioCallbackFn audioCallbackFn) {
+}
+
+void OfflineAudioBackend::start() {
+}
+
+void OfflineAudioBackend::stop() {
+}
+
+AudioBackendStats OfflineAudioBackend::stats() const {
+    return AudioBackendStats{};
+}
+
+bool OfflineAudioBackend::isRealtime() const {
+    return false;
+}
+
+}
@@ -2,20 +2,34 @@
 #include <microtone/log.hpp>
 #include <microtone/midi_input.hpp>
 
+#include <midi_parser.hpp>
+
 #include <rtmidi/RtMidi.h>
 
 #include <atomic>
 #include <chrono>
+#include <mutex>
 #include <thread>
 
 namespace microtone {
 
 class MidiInput::impl {
 public:
-    impl() {
-        _rtMidiConnection = std::make_unique<RtMidiIn>();
-        // Don't ignore sysex, timing, or active sensing messages.
-        _rtMidiConnection->ignoreTypes(false, false, false);
+    // An open port with its own connection, so its messages arrive on its own thread, and its
+    // own parser, since running status doesn't carry over between ports.
+    struct Port {
+        impl* owner;
+        std::unique_ptr<RtMidiIn> connection;
+        MidiParser parser;
+    };
+
+    impl() :
+        _rtMidiConnection{std::make_unique<RtMidiIn>()},
+        _ports{},
+        _parserMutex{},
+        _isRunning{false},
+        _activeCallbacks{0} {
+        _rtMidiConnection->setErrorCallback(&impl::onError, nullptr);
     }
 
     ~impl() {
@@ -30,45 +44,81 @@ public:
         return _rtMidiConnection->getPortName(portNumber);
     }
 
+    // Ports opened while running start delivering straight away.
     void openPort(int portNumber) {
-        _rtMidiConnection->openPort(portNumber);
+        auto port = std::make_unique<Port>(Port{this, std::make_unique<RtMidiIn>(), MidiParser{}});
+        // The synthesizer has no use for sysex, clock or active sensing, and skipping them
+        // saves a wakeup for each.
+        port->connection->ignoreTypes(true, true, true);
+        port->connection->setErrorCallback(&impl::onError, nullptr);
+        port->connection->openPort(portNumber);
+        if (_isRunning.load()) {
+            port->connection->setCallback(&impl::onMessage, port.get());
+        }
+        _ports.push_back(std::move(port));
     }
 
     void start(OnMidiDataFn onReceivedDataFn) {
-        if (!_rtMidiConnection->isPortOpen()) {
+        if (_ports.empty()) {
             throw MicrotoneException("A port must be open to read midi input data.");
         }
 
-        _dataThread = std::thread([onReceivedDataFn, this]() {
-            M_INFO("Started data collection in background thread.");
-            _isRunning.store(true);
-            while (_isRunning.load() == true) {
-                auto message = std::vector<unsigned char>{};
-                _rtMidiConnection->getMessage(&message);
-                if (message.size() == 3) {
-                    auto status = static_cast<int>(message[0]);
-                    auto note = static_cast<int>(message[1]);
-                    auto velocity = static_cast<int>(message[2]);
-
-                    onReceivedDataFn(status, note, velocity);
-                }
-
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            }
-            M_INFO("Stopped data collection.");
-        });
+        stop();
+        _onReceivedDataFn = std::move(onReceivedDataFn);
+        _isRunning.store(true);
+        for (auto& port : _ports) {
+            port->parser = MidiParser{};
+            port->connection->setCallback(&impl::onMessage, port.get());
+        }
+        M_INFO("Started listening for midi input on {} ports.", _ports.size());
+    }
+
+    // RtMidi calls this on each port's own thread as soon as the driver hands a message
+    // over. Ports take turns, so messages reach onReceivedDataFn one at a time and in order
+    // of their timestamps, which are taken on arrival. Reuses RtMidi's buffer and the
+    // parser's state; nothing here allocates.
+    static void onMessage(double, std::vector<unsigned char>* message, void* userData) {
+        auto& port = *static_cast<Port*>(userData);
+        auto& self = *port.owner;
+        self._activeCallbacks.fetch_add(1);
+        if (self._isRunning.load()) {
+            auto lockGuard = std::lock_guard<std::mutex>{self._parserMutex};
+            auto timestamp = std::chrono::steady_clock::now();
+            port.parser.parse(message->data(), message->size(), [&self, timestamp](const MidiMessage& parsed) {
+                self._onReceivedDataFn(parsed.status, parsed.data1, parsed.data2, timestamp);
+            });
+        }
+        self._activeCallbacks.fetch_sub(1);
+    }
+
+    static void onError(RtMidiError::Type type, const std::string& errorText, void*) {
+        if (type == RtMidiError::WARNING || type == RtMidiError::DEBUG_WARNING) {
+            M_WARN("Midi input: {}", errorText);
+        } else {
+            M_ERROR("Midi input: {}", errorText);
+        }
     }
 
     void stop() {
-        if (_isRunning.load() == true) {
-            _isRunning.store(false);
-            _dataThread.join();
+        if (_isRunning.exchange(false)) {
+            for (auto& port : _ports) {
+                port->connection->cancelCallback();
+            }
+            // Messages may still be on their way through on RtMidi's threads, and they
+            // mustn't reach the callback after stop() returns.
+            while (_activeCallbacks.load() > 0) {
+                std::this_thread::yield();
+            }
+            M_INFO("Stopped listening for midi input.");
         }
     }
 
-    std::unique_ptr<RtMidiIn> _rtMidiConnection;
-    std::thread _dataThread;
-    std::atomic<bool> _isRunning = false;
+    std::unique_ptr<RtMidiIn> _rtMidiConnection;    // Lists ports, never opened.
+    std::vector<std::unique_ptr<Port>> _ports;
+    OnMidiDataFn _onReceivedDataFn;
+    std::mutex _parserMutex;                        // Serializes delivery across ports.
+    std::atomic<bool> _isRunning;
+    std::atomic<int> _activeCallbacks;
 };
 
 MidiInput::MidiInput() :
@@ -0,0 +1,48 @@
+#include <midi_parser.hpp>
+
+namespace microtone {
+
+namespace {
+
+int dataLength(int status) {
+    auto message = status & 0xF0;
+    return message == 0xC0 || message == 0xD0 ? 1 : 2;
+}
+
+}
+
+MidiParser::MidiParser() :
+    _runningStatus{0},
+    _data1{0},
+    _dataCount{0} {
+}
+
+bool MidiParser::consume(unsigned char byte, MidiMessage& message) {
+    // Real-time bytes interrupt anything without ending it.
+    if (byte >= 0xF8) {
+        return false;
+    }
+
+    // A channel status byte starts a message and stays in force for the ones after it. Sysex
+    // and system common messages cancel it, so their data is dropped.
+    if (byte >= 0x80) {
+        _runningStatus = byte < 0xF0 ? byte : 0;
+        _dataCount = 0;
+        return false;
+    }
+    if (_runningStatus == 0) {
+        return false;
+    }
+
+    if (_dataCount == 0 && dataLength(_runningStatus) == 2) {
+        _data1 = byte;
+        _dataCount = 1;
+        return false;
+    }
+
+    message = _dataCount == 0 ? MidiMessage{_runningStatus, byte, 0} : MidiMessage{_runningStatus, _data1, byte};
+    _dataCount = 0;
+    return true;
+}
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+
+namespace microtone {
+
+// One channel message. status keeps its channel nibble; data2 is 0 for messages with a
+// single data byte.
+struct MidiMessage {
+    int status;
+    int data1;
+    int data2;
+};
+
+// Splits raw MIDI bytes into channel messages. Buffers may hold several messages, rely on
+// running status or end mid-message; the rest arrives with the next one. Sysex and system
+// common messages are skipped, and real-time bytes may turn up anywhere. Nothing here
+// allocates.
+class MidiParser {
+public:
+    MidiParser();
+
+    // Calls fn(const MidiMessage&) for every message bytes completes.
+    template <typename Fn>
+    void parse(const unsigned char* bytes, std::size_t size, Fn&& fn) {
+        auto message = MidiMessage{};
+        for (std::size_t i = 0; i < size; ++i) {
+            if (consume(bytes[i], message)) {
+                fn(message);
+            }
+        }
+    }
+
+private:
+    // Returns true once byte completes message.
+    bool consume(unsigned char byte, MidiMessage& message);
+
+    int _runningStatus;     // 0 when data bytes have nothing to belong to.
+    int _data1;
+    int _dataCount;
+};
+
+}
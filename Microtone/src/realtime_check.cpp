@@ -0,0 +1,444 @@
+#include <microtone/realtime_check.hpp>
+
+#ifndef MICROTONE_RT_CHECK
+
+namespace microtone {
+
+RealtimeScope::RealtimeScope() {
+}
+
+RealtimeScope::~RealtimeScope() {
+}
+
+std::size_t realtimeViolationCount() {
+    return 0;
+}
+
+}
+
+#else
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <execinfo.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <dlfcn.h>
+#include <poll.h>
+#include <sys/select.h>
+#include <time.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <malloc/malloc.h>
+#endif
+
+namespace microtone {
+
+namespace {
+
+const int MAX_STACK_FRAMES = 64;
+
+std::atomic<std::size_t> violationCount{0};
+
+// Per-thread state: how many RealtimeScopes are open, and whether a report is being written
+// so the hooks don't report the reporter. The hooks run inside malloc, so this avoids
+// thread_local, whose first use on a thread can allocate.
+#if defined(_WIN32)
+
+thread_local int scopeDepth = 0;
+thread_local bool reporting = false;
+
+bool ready() {
+    return true;
+}
+
+int depth() {
+    return scopeDepth;
+}
+
+void setDepth(int depth) {
+    scopeDepth = depth;
+}
+
+bool isReporting() {
+    return reporting;
+}
+
+void setReporting(bool value) {
+    reporting = value;
+}
+
+#else
+
+pthread_key_t depthKey;
+pthread_key_t reportingKey;
+std::atomic<bool> keysCreated{false};
+
+bool ready() {
+    return keysCreated.load(std::memory_order_acquire);
+}
+
+int depth() {
+    return static_cast<int>(reinterpret_cast<std::intptr_t>(pthread_getspecific(depthKey)));
+}
+
+void setDepth(int depth) {
+    pthread_setspecific(depthKey, reinterpret_cast<void*>(static_cast<std::intptr_t>(depth)));
+}
+
+bool isReporting() {
+    return pthread_getspecific(reportingKey) != nullptr;
+}
+
+void setReporting(bool value) {
+    pthread_setspecific(reportingKey, value ? reinterpret_cast<void*>(1) : nullptr);
+}
+
+#endif
+
+void writeError(const char* message) {
+#if defined(_WIN32)
+    std::fputs(message, stderr);
+#else
+    auto length = std::size_t{0};
+    while (message[length] != '\0') {
+        ++length;
+    }
+    [[maybe_unused]] auto written = ::write(STDERR_FILENO, message, length);
+#endif
+}
+
+void writeStackTrace() {
+#if defined(_WIN32)
+    void* frames[MAX_STACK_FRAMES];
+    auto frameCount = CaptureStackBackTrace(0, MAX_STACK_FRAMES, frames, nullptr);
+    for (auto frame = 0; frame < frameCount; ++frame) {
+        char line[64];
+        std::snprintf(line, sizeof(line), "  #%d %p\n", frame, frames[frame]);
+        writeError(line);
+    }
+#else
+    // backtrace_symbols_fd() writes straight to the descriptor without allocating.
+    void* frames[MAX_STACK_FRAMES];
+    auto frameCount = backtrace(frames, MAX_STACK_FRAMES);
+    backtrace_symbols_fd(frames, frameCount, STDERR_FILENO);
+#endif
+}
+
+void reportViolation(const char* call) {
+    if (!ready() || depth() == 0 || isReporting()) {
+        return;
+    }
+
+    setReporting(true);
+    violationCount.fetch_add(1);
+
+    char message[128];
+    std::snprintf(message, sizeof(message), "microtone: real-time violation: %s on a real-time thread\n", call);
+    writeError(message);
+    writeStackTrace();
+
+    setReporting(false);
+}
+
+#if defined(__APPLE__)
+
+// The C library can't be interposed from a static library on macOS, so the hooks sit in
+// the default malloc zone instead. That catches operator new too, which allocates through it.
+void* (*zoneMalloc)(malloc_zone_t*, std::size_t);
+void* (*zoneCalloc)(malloc_zone_t*, std::size_t, std::size_t);
+void* (*zoneRealloc)(malloc_zone_t*, void*, std::size_t);
+void* (*zoneMemalign)(malloc_zone_t*, std::size_t, std::size_t);
+void (*zoneFree)(malloc_zone_t*, void*);
+
+void* checkedZoneMalloc(malloc_zone_t* zone, std::size_t size) {
+    reportViolation("malloc");
+    return zoneMalloc(zone, size);
+}
+
+void* checkedZoneCalloc(malloc_zone_t* zone, std::size_t count, std::size_t size) {
+    reportViolation("calloc");
+    return zoneCalloc(zone, count, size);
+}
+
+void* checkedZoneRealloc(malloc_zone_t* zone, void* pointer, std::size_t size) {
+    reportViolation("realloc");
+    return zoneRealloc(zone, pointer, size);
+}
+
+void* checkedZoneMemalign(malloc_zone_t* zone, std::size_t alignment, std::size_t size) {
+    reportViolation("memalign");
+    return zoneMemalign(zone, alignment, size);
+}
+
+void checkedZoneFree(malloc_zone_t* zone, void* pointer) {
+    if (pointer) {
+        reportViolation("free");
+    }
+    zoneFree(zone, pointer);
+}
+
+void hookMallocZone() {
+    auto zones = static_cast<vm_address_t*>(nullptr);
+    auto zoneCount = 0u;
+    if (malloc_get_all_zones(mach_task_self(), nullptr, &zones, &zoneCount) != KERN_SUCCESS || zoneCount == 0) {
+        return;
+    }
+
+    auto zone = reinterpret_cast<malloc_zone_t*>(zones[0]);
+    vm_protect(mach_task_self(), reinterpret_cast<vm_address_t>(zone), sizeof(malloc_zone_t), 0, VM_PROT_READ | VM_PROT_WRITE);
+    zoneMalloc = zone->malloc;
+    zoneCalloc = zone->calloc;
+    zoneRealloc = zone->realloc;
+    zoneMemalign = zone->memalign;
+    zoneFree = zone->free;
+    zone->malloc = &checkedZoneMalloc;
+    zone->calloc = &checkedZoneCalloc;
+    zone->realloc = &checkedZoneRealloc;
+    if (zone->version >= 5) {
+        zone->memalign = &checkedZoneMemalign;
+    }
+    zone->free = &checkedZoneFree;
+    vm_protect(mach_task_self(), reinterpret_cast<vm_address_t>(zone), sizeof(malloc_zone_t), 0, VM_PROT_READ);
+}
+
+#endif
+
+#if !defined(_WIN32)
+
+bool createKeys() {
+    pthread_key_create(&depthKey, nullptr);
+    pthread_key_create(&reportingKey, nullptr);
+    // The first backtrace() loads the unwinder, which allocates; get that out of the way.
+    void* frames[1];
+    backtrace(frames, 1);
+#if defined(__APPLE__)
+    hookMallocZone();
+#endif
+    keysCreated.store(true, std::memory_order_release);
+    return true;
+}
+
+const bool keysReady = createKeys();
+
+#endif
+
+}
+
+RealtimeScope::RealtimeScope() {
+    if (ready()) {
+        setDepth(depth() + 1);
+    }
+}
+
+RealtimeScope::~RealtimeScope() {
+    if (ready()) {
+        setDepth(depth() - 1);
+    }
+}
+
+std::size_t realtimeViolationCount() {
+    return violationCount.load();
+}
+
+}
+
+#if defined(__linux__)
+
+// glibc lets a program replace malloc by defining it; these forward to glibc's own.
+extern "C" {
+
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* pointer, std::size_t size);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+void __libc_free(void* pointer);
+
+void* malloc(std::size_t size) {
+    microtone::reportViolation("malloc");
+    return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) {
+    microtone::reportViolation("calloc");
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, std::size_t size) {
+    microtone::reportViolation("realloc");
+    return __libc_realloc(pointer, size);
+}
+
+void* memalign(std::size_t alignment, std::size_t size) {
+    microtone::reportViolation("memalign");
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size) {
+    microtone::reportViolation("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** pointer, std::size_t alignment, std::size_t size) {
+    microtone::reportViolation("posix_memalign");
+    *pointer = __libc_memalign(alignment, size);
+    return *pointer ? 0 : ENOMEM;
+}
+
+void free(void* pointer) {
+    if (pointer) {
+        microtone::reportViolation("free");
+    }
+    __libc_free(pointer);
+}
+
+}
+
+namespace {
+
+template <typename Fn>
+Fn nextSymbol(std::atomic<Fn>& cached, const char* name) {
+    auto symbol = cached.load(std::memory_order_relaxed);
+    if (!symbol) {
+        symbol = reinterpret_cast<Fn>(dlsym(RTLD_NEXT, name));
+        cached.store(symbol, std::memory_order_relaxed);
+    }
+    return symbol;
+}
+
+using MutexLockFn = int (*)(pthread_mutex_t*);
+using NanosleepFn = int (*)(const timespec*, timespec*);
+using ClockNanosleepFn = int (*)(clockid_t, int, const timespec*, timespec*);
+using UsleepFn = int (*)(useconds_t);
+using SleepFn = unsigned int (*)(unsigned int);
+using PollFn = int (*)(pollfd*, nfds_t, int);
+using SelectFn = int (*)(int, fd_set*, fd_set*, fd_set*, timeval*);
+using ReadFn = ssize_t (*)(int, void*, std::size_t);
+using WriteFn = ssize_t (*)(int, const void*, std::size_t);
+using JoinFn = int (*)(pthread_t, void**);
+
+std::atomic<MutexLockFn> realMutexLock;
+std::atomic<NanosleepFn> realNanosleep;
+std::atomic<ClockNanosleepFn> realClockNanosleep;
+std::atomic<UsleepFn> realUsleep;
+std::atomic<SleepFn> realSleep;
+std::atomic<PollFn> realPoll;
+std::atomic<SelectFn> realSelect;
+std::atomic<ReadFn> realRead;
+std::atomic<WriteFn> realWrite;
+std::atomic<JoinFn> realJoin;
+
+}
+
+// Condition variable waits aren't hooked: glibc exports two incompatible versions, and
+// waiting takes a mutex first anyway.
+extern "C" {
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) {
+    microtone::reportViolation("pthread_mutex_lock");
+    return nextSymbol(realMutexLock, "pthread_mutex_lock")(mutex);
+}
+
+int nanosleep(const timespec* duration, timespec* remaining) {
+    microtone::reportViolation("nanosleep");
+    return nextSymbol(realNanosleep, "nanosleep")(duration, remaining);
+}
+
+int clock_nanosleep(clockid_t clock, int flags, const timespec* duration, timespec* remaining) {
+    microtone::reportViolation("clock_nanosleep");
+    return nextSymbol(realClockNanosleep, "clock_nanosleep")(clock, flags, duration, remaining);
+}
+
+int usleep(useconds_t microseconds) {
+    microtone::reportViolation("usleep");
+    return nextSymbol(realUsleep, "usleep")(microseconds);
+}
+
+unsigned int sleep(unsigned int seconds) {
+    microtone::reportViolation("sleep");
+    return nextSymbol(realSleep, "sleep")(seconds);
+}
+
+int poll(pollfd* descriptors, nfds_t descriptorCount, int timeout) {
+    microtone::reportViolation("poll");
+    return nextSymbol(realPoll, "poll")(descriptors, descriptorCount, timeout);
+}
+
+int select(int descriptorCount, fd_set* reads, fd_set* writes, fd_set* errors, timeval* timeout) {
+    microtone::reportViolation("select");
+    return nextSymbol(realSelect, "select")(descriptorCount, reads, writes, errors, timeout);
+}
+
+ssize_t read(int descriptor, void* buffer, std::size_t size) {
+    microtone::reportViolation("read");
+    return nextSymbol(realRead, "read")(descriptor, buffer, size);
+}
+
+ssize_t write(int descriptor, const void* buffer, std::size_t size) {
+    microtone::reportViolation("write");
+    return nextSymbol(realWrite, "write")(descriptor, buffer, size);
+}
+
+int pthread_join(pthread_t thread, void** result) {
+    microtone::reportViolation("pthread_join");
+    return nextSymbol(realJoin, "pthread_join")(thread, result);
+}
+
+}
+
+#elif defined(_WIN32)
+
+// MSVC's C library can't be interposed, but operator new can be replaced.
+void* operator new(std::size_t size) {
+    microtone::reportViolation("operator new");
+    if (auto pointer = std::malloc(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size) {
+    microtone::reportViolation("operator new[]");
+    if (auto pointer = std::malloc(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* pointer) noexcept {
+    if (pointer) {
+        microtone::reportViolation("operator delete");
+    }
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    if (pointer) {
+        microtone::reportViolation("operator delete[]");
+    }
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    operator delete[](pointer);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,79 @@
+#include <synthesizer/band_limited_wavetable.hpp>
+
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace microtone {
+
+static_assert(WAVETABLE_LENGTH >> (WAVETABLE_MIP_LEVELS - 1) == 2, "The last mip level must hold only the fundamental.");
+
+namespace {
+
+// In-place iterative radix-2 FFT; inverse when sign is +1. Only used at load time.
+void fft(std::vector<std::complex<double>>& bins, int sign) {
+    const auto size = bins.size();
+    for (std::size_t i = 1, j = 0; i < size; ++i) {
+        auto bit = size >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(bins[i], bins[j]);
+        }
+    }
+
+    for (std::size_t length = 2; length <= size; length <<= 1) {
+        auto angle = sign * 2.0 * M_PI / static_cast<double>(length);
+        auto step = std::complex<double>{std::cos(angle), std::sin(angle)};
+        for (std::size_t start = 0; start < size; start += length) {
+            auto twiddle = std::complex<double>{1.0, 0.0};
+            for (std::size_t k = 0; k < length / 2; ++k) {
+                auto even = bins[start + k];
+                auto odd = bins[start + k + length / 2] * twiddle;
+                bins[start + k] = even + odd;
+                bins[start + k + length / 2] = even - odd;
+                twiddle *= step;
+            }
+        }
+    }
+}
+
+}
+
+BandLimitedWaveTable::BandLimitedWaveTable(const WaveTable& waveTable) :
+    _levels{} {
+    auto spectrum = std::vector<std::complex<double>>(waveTable.begin(), waveTable.end());
+    fft(spectrum, -1);
+
+    for (auto level = 0; level < WAVETABLE_MIP_LEVELS; ++level) {
+        const auto highestHarmonic = (WAVETABLE_LENGTH / 2) >> level;
+        auto bins = spectrum;
+        for (auto harmonic = highestHarmonic + 1; harmonic <= WAVETABLE_LENGTH / 2; ++harmonic) {
+            bins[harmonic] = 0;
+            bins[WAVETABLE_LENGTH - harmonic] = 0;
+        }
+
+        fft(bins, 1);
+        for (auto i = 0; i < WAVETABLE_LENGTH; ++i) {
+            _levels[level][i] = static_cast<float>(bins[i].real() / WAVETABLE_LENGTH);
+        }
+    }
+}
+
+const WaveTable& BandLimitedWaveTable::level(OscillatorPhase phaseIncrement) const {
+    // Level n holds harmonics up to (WAVETABLE_LENGTH / 2) >> n, which stay below Nyquist
+    // while the increment is at most 2^n table samples.
+    auto level = 0;
+    auto limit = (std::uint64_t{1} << 32) / WAVETABLE_LENGTH;
+    while (limit < phaseIncrement && level < WAVETABLE_MIP_LEVELS - 1) {
+        limit *= 2;
+        ++level;
+    }
+    return _levels[level];
+}
+
+}
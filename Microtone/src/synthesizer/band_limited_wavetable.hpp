@@ -0,0 +1,27 @@
+#pragma once
+
+#include <microtone/synthesizer/oscillator_kernel.hpp>
+#include <microtone/synthesizer/wavetable.hpp>
+
+#include <array>
+
+namespace microtone {
+
+// One level per octave, from every harmonic the table can hold down to the fundamental alone.
+const int WAVETABLE_MIP_LEVELS = 9;
+
+// A wave table pre-filtered into octave-spaced, band-limited copies, so every pitch can be
+// played from a level with no harmonics above Nyquist. Built off the audio thread.
+class BandLimitedWaveTable {
+public:
+    explicit BandLimitedWaveTable(const WaveTable& waveTable);
+
+    // The fullest level that stays alias-free when advancing phaseIncrement per output
+    // sample.
+    const WaveTable& level(OscillatorPhase phaseIncrement) const;
+
+private:
+    std::array<WaveTable, WAVETABLE_MIP_LEVELS> _levels;
+};
+
+}
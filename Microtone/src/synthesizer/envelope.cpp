@@ -2,123 +2,36 @@
 #include <microtone/log.hpp>
 #include <microtone/synthesizer/envelope.hpp>
 
+#include <synthesizer/envelope_generator.hpp>
+
+#include <algorithm>
+
 namespace microtone {
 
 class Envelope::impl {
 public:
-    impl(double attack, double decay, double sustain, double release, double sampleRate) :
-        _attack{attack},
-        _decay{decay},
-        _sustain{sustain},
-        _release{release},
+    impl(double attack, double decay, double sustain, double release, EnvelopeCurve curve, double sampleRate) :
+        _shape{attack, decay, sustain, release, curve},
         _sampleRate{sampleRate},
-        _currentValue{0},
-        _increment{0},
-        _counter{0},
-        _state{EnvelopeState::Off} {}
-
-    impl(const impl& other) :
-        _attack{other._attack},
-        _decay{other._decay},
-        _sustain{other._sustain},
-        _release{other._release},
-        _sampleRate{other._sampleRate},
-        _currentValue{other._currentValue},
-        _increment{other._increment},
-        _counter{other._counter},
-        _state{other._state} {}
-
-    EnvelopeState state() {
-        return _state;
-    }
-
-    double attack() {
-        return _attack;
-    }
-
-    double decay() {
-        return _decay;
-    }
-
-    double sustain() {
-        return _sustain;
-    }
-
-    double release() {
-        return _release;
-    }
-
-    void setAttack(double attack) {
-        _attack = attack;
-    }
-
-    void setDecay(double decay) {
-        _decay = decay;
-    }
-
-    void setSustain(double sustain) {
-        _sustain = sustain;
-    }
-
-    void setRelease(double release) {
-        _release = release;
-    }
+        _generator{EnvelopeState::Off, 0.0f, EnvelopeSegment{1.0f, 0.0f, 0.0f, 0}} {}
 
-    void triggerOn() {
-        _state = EnvelopeState::Attack;
-        rampTo(1.0, _attack);                                   // perform attack
-    }
-
-    void triggerOff() {
-        _state = EnvelopeState::Release;
-        rampTo(0, _release);                                    // perform release
-    }
-
-    void setValue(float value) {
-        _currentValue = value;
-        _increment = 0;
-        _counter = 0;
-    }
-
-    void rampTo(double value, double time) {
-        _increment = (value - _currentValue) / (_sampleRate * time);
-        _counter = static_cast<int>(_sampleRate * time);
-    }
-
-    float nextSample() {
-        if (_counter > 0) {
-            _counter--;
-            _currentValue += static_cast<float>(_increment);
-        }
-
-        // Finished current phase.
-        if (_counter == 0) {
-            if (_state == EnvelopeState::Attack) {
-                _state = EnvelopeState::Decay;
-                rampTo(_sustain, _decay);                       // perform decay
-            } else if (_state == EnvelopeState::Decay) {
-                _state = EnvelopeState::Sustain;
-            } else if (_state == EnvelopeState::Release) {
-                _state = EnvelopeState::Off;
-            }
+    void processBlock(float* out, int frames) {
+        if (renderEnvelope(_generator, _shape, _sampleRate, out, frames)) {
+            std::fill(out, out + frames, _generator.level);
         }
-
-        return _currentValue;
     }
 
-    double _attack;
-    double _decay;
-    double _sustain;
-    double _release;
+    EnvelopeShape _shape;
     double _sampleRate;
-    float _currentValue;
-    double _increment;
-    int _counter;
-    EnvelopeState _state;
+    EnvelopeGenerator _generator;
 };
 
 Envelope::Envelope(double attack, double decay, double sustain, double release, double sampleRate) :
-    _impl{new impl{attack, decay, sustain, release, sampleRate}} {
+    _impl{new impl{attack, decay, sustain, release, EnvelopeCurve::Linear, sampleRate}} {
+}
+
+Envelope::Envelope(double attack, double decay, double sustain, double release, EnvelopeCurve curve, double sampleRate) :
+    _impl{new impl{attack, decay, sustain, release, curve, sampleRate}} {
 }
 
 Envelope::Envelope(const Envelope& other) :
@@ -141,54 +54,68 @@ Envelope& Envelope::operator=(Envelope&& other) noexcept {
     return *this;
 }
 
-EnvelopeState Envelope::state() {
-    return _impl->state();
+EnvelopeState Envelope::state() const {
+    return _impl->_generator.state;
+}
+
+double Envelope::attack() const {
+    return _impl->_shape.attack;
 }
 
-double Envelope::attack() {
-    return _impl->attack();
+double Envelope::decay() const {
+    return _impl->_shape.decay;
 }
 
-double Envelope::decay() {
-    return _impl->decay();
+double Envelope::sustain() const {
+    return _impl->_shape.sustain;
 }
 
-double Envelope::sustain() {
-    return _impl->sustain();
+double Envelope::release() const {
+    return _impl->_shape.release;
 }
 
-double Envelope::release() {
-    return _impl->release();
+EnvelopeCurve Envelope::curve() const {
+    return _impl->_shape.curve;
 }
 
 void Envelope::setAttack(double attack) {
-    _impl->setAttack(attack);
+    _impl->_shape.attack = attack;
 }
 
 void Envelope::setDecay(double decay) {
-    _impl->setDecay(decay);
+    _impl->_shape.decay = decay;
 }
 
 void Envelope::setSustain(double sustain) {
-    _impl->setSustain(sustain);
+    _impl->_shape.sustain = sustain;
 }
 
 void Envelope::setRelease(double release) {
-    _impl->setRelease(release);
+    _impl->_shape.release = release;
+}
+
+void Envelope::setCurve(EnvelopeCurve curve) {
+    _impl->_shape.curve = curve;
 }
 
 Envelope::~Envelope() = default;
 
 void Envelope::triggerOn() {
-    _impl->triggerOn();
+    triggerEnvelopeOn(_impl->_generator, _impl->_shape, _impl->_sampleRate);
 }
 
 void Envelope::triggerOff() {
-    _impl->triggerOff();
+    triggerEnvelopeOff(_impl->_generator, _impl->_shape, _impl->_sampleRate);
 }
 
 float Envelope::nextSample() {
-    return _impl->nextSample();
+    auto sample = 0.0f;
+    _impl->processBlock(&sample, 1);
+    return sample;
+}
+
+void Envelope::processBlock(float* out, int frames) {
+    _impl->processBlock(out, frames);
 }
 
 }
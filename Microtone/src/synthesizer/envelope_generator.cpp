@@ -0,0 +1,98 @@
+#include <synthesizer/envelope_generator.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace microtone {
+
+namespace {
+
+// How far past its target an exponential segment aims, as a fraction of the distance it
+// covers; the smaller, the harder it bends. Attacks aim well past full level so they rise
+// steeply and ease in, like a charging capacitor. Decays and releases fall by 60dB of the
+// way before they land.
+const double ATTACK_OVERSHOOT = 0.3;
+const double DECAY_OVERSHOOT = 0.001;
+
+EnvelopeSegment makeSegment(EnvelopeCurve curve, float from, float to, double time, double overshoot, double sampleRate) {
+    // A zero length stage still takes a sample, so it jumps rather than never arriving.
+    auto frames = std::max(1, static_cast<int>(std::lround(time * sampleRate)));
+    if (from == to) {
+        return {1.0f, 0.0f, to, frames};
+    }
+    if (curve == EnvelopeCurve::Linear) {
+        return {1.0f, (to - from) / frames, to, frames};
+    }
+
+    // The distance left to aim shrinks by multiplier every sample, which puts the level on
+    // to after frames samples wherever it started.
+    auto aim = to + overshoot * (to - from);
+    auto multiplier = std::pow(overshoot / (1.0 + overshoot), 1.0 / frames);
+    return {static_cast<float>(multiplier), static_cast<float>(aim * (1.0 - multiplier)), to, frames};
+}
+
+// Finished the current segment.
+void advanceEnvelope(EnvelopeGenerator& envelope, const EnvelopeShape& shape, double sampleRate) {
+    if (envelope.state == EnvelopeState::Attack) {
+        envelope.state = EnvelopeState::Decay;
+        envelope.segment = makeSegment(shape.curve, envelope.level, static_cast<float>(shape.sustain), shape.decay, DECAY_OVERSHOOT, sampleRate);
+    } else if (envelope.state == EnvelopeState::Decay) {
+        envelope.state = EnvelopeState::Sustain;
+    } else if (envelope.state == EnvelopeState::Release) {
+        envelope.state = EnvelopeState::Off;
+    }
+}
+
+}
+
+void triggerEnvelopeOn(EnvelopeGenerator& envelope, const EnvelopeShape& shape, double sampleRate) {
+    // A retrigger covers what's left of the attack at the attack's usual rate.
+    auto remaining = std::max(0.0f, 1.0f - envelope.level);
+    envelope.state = EnvelopeState::Attack;
+    envelope.segment = makeSegment(shape.curve, envelope.level, 1.0f, shape.attack * remaining, ATTACK_OVERSHOOT, sampleRate);
+}
+
+void triggerEnvelopeOff(EnvelopeGenerator& envelope, const EnvelopeShape& shape, double sampleRate) {
+    envelope.state = EnvelopeState::Release;
+    envelope.segment = makeSegment(shape.curve, envelope.level, 0.0f, shape.release, DECAY_OVERSHOOT, sampleRate);
+}
+
+bool renderEnvelope(EnvelopeGenerator& envelope, const EnvelopeShape& shape, double sampleRate, float* out, int frames) {
+    auto& segment = envelope.segment;
+    // Sustain and Off hold, and so does a segment that goes nowhere.
+    auto flat = segment.multiplier == 1.0f && segment.offset == 0.0f;
+    if (segment.frames == 0 || (flat && segment.frames > frames)) {
+        segment.frames = std::max(segment.frames - frames, 0);
+        return true;
+    }
+
+    auto frame = 0;
+    while (frame < frames) {
+        if (segment.frames == 0) {
+            std::fill(out + frame, out + frames, envelope.level);
+            break;
+        }
+
+        auto segmentFrames = std::min(segment.frames, frames - frame);
+        auto level = envelope.level;
+        const auto multiplier = segment.multiplier;
+        const auto offset = segment.offset;
+        for (auto i = 0; i < segmentFrames; ++i) {
+            level = level * multiplier + offset;
+            out[frame + i] = level;
+        }
+        segment.frames -= segmentFrames;
+        frame += segmentFrames;
+        envelope.level = level;
+
+        if (segment.frames == 0) {
+            // Land exactly, whatever rounding built up on the way.
+            envelope.level = segment.target;
+            out[frame - 1] = segment.target;
+            advanceEnvelope(envelope, shape, sampleRate);
+        }
+    }
+    return false;
+}
+
+}
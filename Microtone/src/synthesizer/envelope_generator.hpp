@@ -0,0 +1,42 @@
+#pragma once
+
+#include <microtone/synthesizer/envelope.hpp>
+
+namespace microtone {
+
+// One stage of an envelope. The level follows level = level * multiplier + offset, a
+// straight line when multiplier is 1 and an exponential otherwise, and lands exactly on
+// target after frames samples.
+struct EnvelopeSegment {
+    float multiplier;
+    float offset;
+    float target;
+    int frames;
+};
+
+struct EnvelopeShape {
+    double attack;
+    double decay;
+    double sustain;
+    double release;
+    EnvelopeCurve curve;
+};
+
+// The state of one envelope, small enough to keep an array of them.
+struct EnvelopeGenerator {
+    EnvelopeState state;
+    float level;
+    EnvelopeSegment segment;
+};
+
+// Both start from whatever level the envelope is at, so retriggering a sounding envelope
+// doesn't click.
+void triggerEnvelopeOn(EnvelopeGenerator& envelope, const EnvelopeShape& shape, double sampleRate);
+void triggerEnvelopeOff(EnvelopeGenerator& envelope, const EnvelopeShape& shape, double sampleRate);
+
+// Writes the next frames of the envelope to out and returns false. If the level holds
+// still over all of them it writes nothing and returns true instead, so the caller can
+// fill or multiply by envelope.level in one go.
+bool renderEnvelope(EnvelopeGenerator& envelope, const EnvelopeShape& shape, double sampleRate, float* out, int frames);
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace microtone {
+
+// Bounded multi-producer, single-consumer queue, after Dmitry Vyukov's bounded MPMC queue.
+// push() never blocks and fails when the queue is full; pop() is wait-free. Neither allocates,
+// so the audio thread can drain it.
+template <typename T, std::size_t Capacity>
+class EventQueue {
+    static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+
+public:
+    EventQueue() :
+        _cells{},
+        _enqueuePosition{0},
+        _dequeuePosition{0} {
+        for (std::size_t i = 0; i < Capacity; ++i) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    EventQueue(const EventQueue&) = delete;
+    EventQueue& operator=(const EventQueue&) = delete;
+
+    bool push(const T& value) {
+        auto position = _enqueuePosition.load(std::memory_order_relaxed);
+        while (true) {
+            auto& cell = _cells[position & MASK];
+            auto sequence = cell.sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+            if (difference == 0) {
+                if (_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = _enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Must only be called from the single consumer thread.
+    bool pop(T& value) {
+        auto& cell = _cells[_dequeuePosition & MASK];
+        auto sequence = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(_dequeuePosition + 1) < 0) {
+            return false;
+        }
+
+        value = cell.value;
+        cell.sequence.store(_dequeuePosition + Capacity, std::memory_order_release);
+        ++_dequeuePosition;
+        return true;
+    }
+
+private:
+    static constexpr std::size_t MASK = Capacity - 1;
+
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::array<Cell, Capacity> _cells;
+    alignas(64) std::atomic<std::size_t> _enqueuePosition;
+    alignas(64) std::size_t _dequeuePosition;
+};
+
+}
@@ -1,29 +1,51 @@
 #include <microtone/synthesizer/filter.hpp>
 
+#include <synthesizer/filter_bank.hpp>
+
+#include <algorithm>
+
 namespace microtone {
 
 class Filter::impl {
 public:
-    impl() :
-        _lastSample{0},
-        _alpha{0.5} {}
-
-    impl(const impl& other) :
-        _lastSample{other._lastSample},
-        _alpha{other._alpha} {}
-
-    float nextSample(float in) {
-        auto out = static_cast<float>(_alpha * _lastSample + (1.0 - _alpha) * in);
-        _lastSample = out;
-        return out;
+    impl(FilterMode mode, FilterTopology topology, double cutoff, double resonance, double sampleRate) :
+        _mode{mode},
+        _topology{topology},
+        _cutoff{std::clamp(cutoff, MIN_FILTER_CUTOFF, MAX_FILTER_CUTOFF_RATIO * sampleRate)},
+        _resonance{resonance},
+        _sampleRate{sampleRate},
+        _coefficients{},
+        _state{} {
+        updateCoefficients();
+    }
+
+    void updateCoefficients() {
+        _coefficients = filterCoefficients(_mode, _topology, _cutoff, _resonance, _sampleRate);
+    }
+
+    void processBlock(float* inOut, int frames) {
+        auto state = _state;
+        for (auto frame = 0; frame < frames; ++frame) {
+            inOut[frame] = filterSample(_topology, _coefficients, state, inOut[frame]);
+        }
+        _state = state;
     }
 
-    float _lastSample;
-    double _alpha;
+    FilterMode _mode;
+    FilterTopology _topology;
+    double _cutoff;
+    double _resonance;
+    double _sampleRate;
+    FilterCoefficients _coefficients;
+    FilterState _state;
 };
 
 Filter::Filter() :
-    _impl{new impl{}} {
+    _impl{new impl{FilterMode::LowPass, FilterTopology::StateVariable, DEFAULT_FILTER_CUTOFF, DEFAULT_FILTER_RESONANCE, 48000}} {
+}
+
+Filter::Filter(FilterMode mode, FilterTopology topology, double cutoff, double resonance, double sampleRate) :
+    _impl{new impl{mode, topology, cutoff, resonance, sampleRate}} {
 }
 
 Filter::Filter(const Filter& other) :
@@ -46,8 +68,39 @@ Filter& Filter::operator=(Filter&& other) noexcept {
     return *this;
 }
 
+FilterMode Filter::mode() const {
+    return _impl->_mode;
+}
+
+FilterTopology Filter::topology() const {
+    return _impl->_topology;
+}
+
+double Filter::cutoff() const {
+    return _impl->_cutoff;
+}
+
+double Filter::resonance() const {
+    return _impl->_resonance;
+}
+
+void Filter::setCutoff(double cutoff) {
+    _impl->_cutoff = std::clamp(cutoff, MIN_FILTER_CUTOFF, MAX_FILTER_CUTOFF_RATIO * _impl->_sampleRate);
+    _impl->updateCoefficients();
+}
+
+void Filter::setResonance(double resonance) {
+    _impl->_resonance = resonance;
+    _impl->updateCoefficients();
+}
+
 float Filter::nextSample(float in) {
-    return _impl->nextSample(in);
+    _impl->processBlock(&in, 1);
+    return in;
+}
+
+void Filter::processBlock(float* inOut, int frames) {
+    _impl->processBlock(inOut, frames);
 }
 
 Filter::~Filter() = default;
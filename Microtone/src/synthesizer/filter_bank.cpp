@@ -0,0 +1,324 @@
+#include <microtone/synthesizer/oscillator_kernel.hpp>
+
+#include <synthesizer/filter_bank.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define MICROTONE_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MICROTONE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MICROTONE_TARGET(isa)
+#endif
+
+namespace microtone {
+
+static_assert(FILTER_LANES == 8, "The vector kernels work on two sets of four lanes.");
+
+namespace {
+
+// Keeps a very low resonance from blowing up the state variable feedback.
+const double MIN_FILTER_RESONANCE = 0.1;
+
+FilterCoefficients stateVariableCoefficients(FilterMode mode, double cutoff, double resonance, double sampleRate) {
+    auto g = std::tan(M_PI * cutoff / sampleRate);
+    auto k = 1.0 / resonance;
+    auto a1 = 1.0 / (1.0 + g * (g + k));
+    auto a2 = g * a1;
+    auto a3 = g * a2;
+
+    // Mixes of the input, band-pass and low-pass outputs.
+    auto m0 = 0.0;
+    auto m1 = 0.0;
+    auto m2 = 0.0;
+    switch (mode) {
+    case FilterMode::LowPass:
+        m2 = 1.0;
+        break;
+    case FilterMode::HighPass:
+        m0 = 1.0;
+        m1 = -k;
+        m2 = -1.0;
+        break;
+    case FilterMode::BandPass:
+        m1 = k;
+        break;
+    }
+
+    return {static_cast<float>(a1), static_cast<float>(a2), static_cast<float>(a3),
+            static_cast<float>(m0), static_cast<float>(m1), static_cast<float>(m2)};
+}
+
+FilterCoefficients biquadCoefficients(FilterMode mode, double cutoff, double resonance, double sampleRate) {
+    auto w0 = 2.0 * M_PI * cutoff / sampleRate;
+    auto cosW0 = std::cos(w0);
+    auto alpha = std::sin(w0) / (2.0 * resonance);
+
+    auto b0 = 0.0;
+    auto b1 = 0.0;
+    auto b2 = 0.0;
+    switch (mode) {
+    case FilterMode::LowPass:
+        b0 = (1.0 - cosW0) / 2.0;
+        b1 = 1.0 - cosW0;
+        b2 = b0;
+        break;
+    case FilterMode::HighPass:
+        b0 = (1.0 + cosW0) / 2.0;
+        b1 = -(1.0 + cosW0);
+        b2 = b0;
+        break;
+    case FilterMode::BandPass:
+        b0 = alpha;
+        b2 = -alpha;
+        break;
+    }
+
+    auto a0 = 1.0 + alpha;
+    return {static_cast<float>(b0 / a0), static_cast<float>(b1 / a0), static_cast<float>(b2 / a0),
+            static_cast<float>(-2.0 * cosW0 / a0), static_cast<float>((1.0 - alpha) / a0), 0.0f};
+}
+
+template <FilterTopology Topology>
+inline float scalarStep(const float* c, float& s1, float& s2, float x) {
+    if constexpr (Topology == FilterTopology::StateVariable) {
+        auto v3 = x - s2;
+        auto v1 = c[0] * s1 + c[1] * v3;
+        auto v2 = s2 + c[1] * s1 + c[2] * v3;
+        s1 = 2.0f * v1 - s1;
+        s2 = 2.0f * v2 - s2;
+        return c[3] * x + c[4] * v1 + c[5] * v2;
+    } else {
+        auto y = c[0] * x + s1;
+        s1 = c[1] * x - c[3] * y + s2;
+        s2 = c[2] * x - c[4] * y;
+        return y;
+    }
+}
+
+template <FilterTopology Topology>
+void scalarKernel(FilterLanes& lanes, int laneCount, const float* in, int inStride, float* out, int frames) {
+    for (auto lane = 0; lane < laneCount; ++lane) {
+        float c[FILTER_COEFFICIENT_COUNT];
+        for (auto i = 0; i < FILTER_COEFFICIENT_COUNT; ++i) {
+            c[i] = lanes.coefficients[i][lane];
+        }
+        auto s1 = lanes.s1[lane];
+        auto s2 = lanes.s2[lane];
+        const auto* laneIn = in + lane * inStride;
+        for (auto frame = 0; frame < frames; ++frame) {
+            out[frame] += scalarStep<Topology>(c, s1, s2, laneIn[frame]);
+        }
+        lanes.s1[lane] = s1;
+        lanes.s2[lane] = s2;
+    }
+}
+
+#ifdef MICROTONE_X86
+
+// The filters are recursive in time, so the vectors run across voices instead: every
+// lane is a voice, and four frames of four voices are transposed in and out of registers.
+
+template <FilterTopology Topology>
+MICROTONE_TARGET("sse2")
+inline __m128 sse2Step(const __m128* c, __m128& s1, __m128& s2, __m128 x) {
+    if constexpr (Topology == FilterTopology::StateVariable) {
+        auto v3 = _mm_sub_ps(x, s2);
+        auto v1 = _mm_add_ps(_mm_mul_ps(c[0], s1), _mm_mul_ps(c[1], v3));
+        auto v2 = _mm_add_ps(s2, _mm_add_ps(_mm_mul_ps(c[1], s1), _mm_mul_ps(c[2], v3)));
+        s1 = _mm_sub_ps(_mm_add_ps(v1, v1), s1);
+        s2 = _mm_sub_ps(_mm_add_ps(v2, v2), s2);
+        return _mm_add_ps(_mm_mul_ps(c[3], x), _mm_add_ps(_mm_mul_ps(c[4], v1), _mm_mul_ps(c[5], v2)));
+    } else {
+        auto y = _mm_add_ps(_mm_mul_ps(c[0], x), s1);
+        s1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c[1], x), _mm_mul_ps(c[3], y)), s2);
+        s2 = _mm_sub_ps(_mm_mul_ps(c[2], x), _mm_mul_ps(c[4], y));
+        return y;
+    }
+}
+
+MICROTONE_TARGET("sse2")
+inline float sse2Sum(__m128 v) {
+    auto pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+}
+
+template <FilterTopology Topology>
+MICROTONE_TARGET("sse2")
+void sse2Kernel(FilterLanes& lanes, int laneCount, const float* in, int inStride, float* out, int frames) {
+    for (auto first = 0; first < laneCount; first += 4) {
+        __m128 c[FILTER_COEFFICIENT_COUNT];
+        for (auto i = 0; i < FILTER_COEFFICIENT_COUNT; ++i) {
+            c[i] = _mm_load_ps(&lanes.coefficients[i][first]);
+        }
+        auto s1 = _mm_load_ps(&lanes.s1[first]);
+        auto s2 = _mm_load_ps(&lanes.s2[first]);
+        const auto* in0 = in + (first + 0) * inStride;
+        const auto* in1 = in + (first + 1) * inStride;
+        const auto* in2 = in + (first + 2) * inStride;
+        const auto* in3 = in + (first + 3) * inStride;
+
+        auto frame = 0;
+        for (; frame + 4 <= frames; frame += 4) {
+            auto x0 = _mm_loadu_ps(in0 + frame);
+            auto x1 = _mm_loadu_ps(in1 + frame);
+            auto x2 = _mm_loadu_ps(in2 + frame);
+            auto x3 = _mm_loadu_ps(in3 + frame);
+            _MM_TRANSPOSE4_PS(x0, x1, x2, x3);
+
+            auto y0 = sse2Step<Topology>(c, s1, s2, x0);
+            auto y1 = sse2Step<Topology>(c, s1, s2, x1);
+            auto y2 = sse2Step<Topology>(c, s1, s2, x2);
+            auto y3 = sse2Step<Topology>(c, s1, s2, x3);
+            _MM_TRANSPOSE4_PS(y0, y1, y2, y3);
+
+            auto sum = _mm_add_ps(_mm_add_ps(y0, y1), _mm_add_ps(y2, y3));
+            _mm_storeu_ps(out + frame, _mm_add_ps(_mm_loadu_ps(out + frame), sum));
+        }
+        for (; frame < frames; ++frame) {
+            auto x = _mm_set_ps(in3[frame], in2[frame], in1[frame], in0[frame]);
+            out[frame] += sse2Sum(sse2Step<Topology>(c, s1, s2, x));
+        }
+
+        _mm_store_ps(&lanes.s1[first], s1);
+        _mm_store_ps(&lanes.s2[first], s2);
+    }
+}
+
+template <FilterTopology Topology>
+MICROTONE_TARGET("avx2,fma")
+inline __m256 avx2Step(const __m256* c, __m256& s1, __m256& s2, __m256 x) {
+    const auto two = _mm256_set1_ps(2.0f);
+    if constexpr (Topology == FilterTopology::StateVariable) {
+        auto v3 = _mm256_sub_ps(x, s2);
+        auto v1 = _mm256_fmadd_ps(c[0], s1, _mm256_mul_ps(c[1], v3));
+        auto v2 = _mm256_add_ps(s2, _mm256_fmadd_ps(c[1], s1, _mm256_mul_ps(c[2], v3)));
+        s1 = _mm256_fmsub_ps(two, v1, s1);
+        s2 = _mm256_fmsub_ps(two, v2, s2);
+        return _mm256_fmadd_ps(c[3], x, _mm256_fmadd_ps(c[4], v1, _mm256_mul_ps(c[5], v2)));
+    } else {
+        auto y = _mm256_fmadd_ps(c[0], x, s1);
+        s1 = _mm256_fmadd_ps(c[1], x, _mm256_fnmadd_ps(c[3], y, s2));
+        s2 = _mm256_fnmadd_ps(c[4], y, _mm256_mul_ps(c[2], x));
+        return y;
+    }
+}
+
+// Adds the two halves, leaving one sum per pair of lanes l and l + 4.
+MICROTONE_TARGET("avx2,fma")
+inline __m128 avx2Fold(__m256 v) {
+    return _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+}
+
+MICROTONE_TARGET("avx2,fma")
+inline __m256 avx2Combine(__m128 low, __m128 high) {
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+}
+
+template <FilterTopology Topology>
+MICROTONE_TARGET("avx2,fma")
+void avx2Kernel(FilterLanes& lanes, int laneCount, const float* in, int inStride, float* out, int frames) {
+    // Half the lanes would be idle.
+    if (laneCount <= 4) {
+        sse2Kernel<Topology>(lanes, laneCount, in, inStride, out, frames);
+        return;
+    }
+
+    __m256 c[FILTER_COEFFICIENT_COUNT];
+    for (auto i = 0; i < FILTER_COEFFICIENT_COUNT; ++i) {
+        c[i] = _mm256_load_ps(lanes.coefficients[i].data());
+    }
+    auto s1 = _mm256_load_ps(lanes.s1.data());
+    auto s2 = _mm256_load_ps(lanes.s2.data());
+    const float* rows[FILTER_LANES];
+    for (auto lane = 0; lane < FILTER_LANES; ++lane) {
+        rows[lane] = in + lane * inStride;
+    }
+
+    auto frame = 0;
+    for (; frame + 4 <= frames; frame += 4) {
+        auto low0 = _mm_loadu_ps(rows[0] + frame);
+        auto low1 = _mm_loadu_ps(rows[1] + frame);
+        auto low2 = _mm_loadu_ps(rows[2] + frame);
+        auto low3 = _mm_loadu_ps(rows[3] + frame);
+        _MM_TRANSPOSE4_PS(low0, low1, low2, low3);
+        auto high0 = _mm_loadu_ps(rows[4] + frame);
+        auto high1 = _mm_loadu_ps(rows[5] + frame);
+        auto high2 = _mm_loadu_ps(rows[6] + frame);
+        auto high3 = _mm_loadu_ps(rows[7] + frame);
+        _MM_TRANSPOSE4_PS(high0, high1, high2, high3);
+
+        auto y0 = avx2Fold(avx2Step<Topology>(c, s1, s2, avx2Combine(low0, high0)));
+        auto y1 = avx2Fold(avx2Step<Topology>(c, s1, s2, avx2Combine(low1, high1)));
+        auto y2 = avx2Fold(avx2Step<Topology>(c, s1, s2, avx2Combine(low2, high2)));
+        auto y3 = avx2Fold(avx2Step<Topology>(c, s1, s2, avx2Combine(low3, high3)));
+        _MM_TRANSPOSE4_PS(y0, y1, y2, y3);
+
+        auto sum = _mm_add_ps(_mm_add_ps(y0, y1), _mm_add_ps(y2, y3));
+        _mm_storeu_ps(out + frame, _mm_add_ps(_mm_loadu_ps(out + frame), sum));
+    }
+    for (; frame < frames; ++frame) {
+        auto x = _mm256_set_ps(rows[7][frame], rows[6][frame], rows[5][frame], rows[4][frame],
+                               rows[3][frame], rows[2][frame], rows[1][frame], rows[0][frame]);
+        out[frame] += sse2Sum(avx2Fold(avx2Step<Topology>(c, s1, s2, x)));
+    }
+
+    _mm256_store_ps(lanes.s1.data(), s1);
+    _mm256_store_ps(lanes.s2.data(), s2);
+}
+
+#endif
+
+template <FilterTopology Topology>
+FilterBankKernelFn bestKernel() {
+#ifdef MICROTONE_X86
+    switch (bestOscillatorKernel()) {
+    case OscillatorKernel::Avx512:
+    case OscillatorKernel::Avx2:
+        return &avx2Kernel<Topology>;
+    case OscillatorKernel::Sse2:
+        return &sse2Kernel<Topology>;
+    case OscillatorKernel::Scalar:
+        break;
+    }
+#endif
+    return &scalarKernel<Topology>;
+}
+
+}
+
+FilterCoefficients filterCoefficients(FilterMode mode, FilterTopology topology, double cutoff, double resonance, double sampleRate) {
+    cutoff = std::clamp(cutoff, MIN_FILTER_CUTOFF, MAX_FILTER_CUTOFF_RATIO * sampleRate);
+    resonance = std::max(resonance, MIN_FILTER_RESONANCE);
+    if (topology == FilterTopology::StateVariable) {
+        return stateVariableCoefficients(mode, cutoff, resonance, sampleRate);
+    }
+    return biquadCoefficients(mode, cutoff, resonance, sampleRate);
+}
+
+float filterSample(FilterTopology topology, const FilterCoefficients& coefficients, FilterState& state, float in) {
+    if (topology == FilterTopology::StateVariable) {
+        return scalarStep<FilterTopology::StateVariable>(coefficients.data(), state.s1, state.s2, in);
+    }
+    return scalarStep<FilterTopology::Biquad>(coefficients.data(), state.s1, state.s2, in);
+}
+
+FilterBankKernelFn filterBankKernel(FilterTopology topology) {
+    static const auto stateVariable = bestKernel<FilterTopology::StateVariable>();
+    static const auto biquad = bestKernel<FilterTopology::Biquad>();
+    return topology == FilterTopology::StateVariable ? stateVariable : biquad;
+}
+
+FilterBankKernelFn scalarFilterBankKernel(FilterTopology topology) {
+    if (topology == FilterTopology::StateVariable) {
+        return &scalarKernel<FilterTopology::StateVariable>;
+    }
+    return &scalarKernel<FilterTopology::Biquad>;
+}
+
+}
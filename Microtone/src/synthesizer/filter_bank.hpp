@@ -0,0 +1,50 @@
+#pragma once
+
+#include <microtone/synthesizer/filter.hpp>
+
+#include <array>
+
+namespace microtone {
+
+// Voices filtered at once, one per SIMD lane.
+const int FILTER_LANES = 8;
+const int FILTER_COEFFICIENT_COUNT = 6;
+// Cutoffs are clamped into [MIN_FILTER_CUTOFF, MAX_FILTER_CUTOFF_RATIO * sample rate].
+const double MIN_FILTER_CUTOFF = 20.0;
+const double MAX_FILTER_CUTOFF_RATIO = 0.45;
+
+// A state variable filter uses all six: a1, a2, a3, then how much of the input, band-pass
+// and low-pass outputs to mix. A biquad uses b0, b1, b2, a1, a2 and leaves the last at 0.
+using FilterCoefficients = std::array<float, FILTER_COEFFICIENT_COUNT>;
+
+FilterCoefficients filterCoefficients(FilterMode mode, FilterTopology topology, double cutoff, double resonance, double sampleRate);
+
+// Both topologies keep two state variables: the integrators of a state variable filter,
+// or the delays of a biquad.
+struct FilterState {
+    float s1;
+    float s2;
+};
+
+// The filter of one voice, one sample at a time. The kernels below do the same per lane.
+float filterSample(FilterTopology topology, const FilterCoefficients& coefficients, FilterState& state, float in);
+
+// Coefficients and state of up to FILTER_LANES voices, laid out so a vector holds one
+// value of every lane.
+struct FilterLanes {
+    alignas(32) std::array<std::array<float, FILTER_LANES>, FILTER_COEFFICIENT_COUNT> coefficients;
+    alignas(32) std::array<float, FILTER_LANES> s1;
+    alignas(32) std::array<float, FILTER_LANES> s2;
+};
+
+// Filters frames samples of laneCount inputs through the matching lanes and adds the sum
+// of their outputs to out. Lane l reads in[l * inStride + frame]. Lanes up to the next
+// multiple of four past laneCount must have zero coefficients and zero input.
+using FilterBankKernelFn = void (*)(FilterLanes& lanes, int laneCount, const float* in, int inStride, float* out, int frames);
+
+// The widest kernel this CPU supports for topology, picked along with the oscillator kernel.
+FilterBankKernelFn filterBankKernel(FilterTopology topology);
+// The reference the vector kernels are checked against.
+FilterBankKernelFn scalarFilterBankKernel(FilterTopology topology);
+
+}
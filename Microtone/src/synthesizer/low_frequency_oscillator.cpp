@@ -1,32 +1,67 @@
 #include <microtone/synthesizer/low_frequency_oscillator.hpp>
-#include <microtone/synthesizer/oscillator.hpp>
 #include <microtone/synthesizer/wavetable.hpp>
 
 #include <cmath>
-#include <vector>
 
 namespace microtone {
 
+namespace {
+
+const WaveTable& sineWaveTable() {
+    static const auto waveTable = [] {
+        auto table = WaveTable{};
+        for (auto i = 0; i < WAVETABLE_LENGTH; ++i) {
+            table[i] = static_cast<float>(std::sin(2.0 * M_PI * i / WAVETABLE_LENGTH));
+        }
+        return table;
+    }();
+    return waveTable;
+}
+
+}
+
 class LowFrequencyOscillator::impl {
 public:
     impl(double frequency, double sampleRate) :
-        _oscillator{frequency, sampleRate},
-        _waveTable{} {
-        for (auto i = 0; i < microtone::WAVETABLE_LENGTH; ++i) {
-            _waveTable[i] = std::sin(2.0 * M_PI * i / microtone::WAVETABLE_LENGTH);
-        }
+        _sampleRate{sampleRate},
+        _phase{0},
+        _phaseIncrement{0},
+        _waveTable{sineWaveTable()} {
+        setFrequency(frequency);
+    }
+
+    impl(const impl& other) = default;
+
+    void setFrequency(double frequency) {
+        _phaseIncrement = WAVETABLE_LENGTH * frequency / _sampleRate;
     }
 
-    impl(const impl& other) :
-        _oscillator{other._oscillator},
-        _waveTable{other._waveTable} {}
+    float value() const {
+        // Linear interpolation improves the signal approximation accuracy at discrete index.
+        auto indexBelow = static_cast<int>(_phase);
+        auto indexAbove = (indexBelow + 1) % WAVETABLE_LENGTH;
+        auto fractionAbove = _phase - indexBelow;
+        auto fractionBelow = 1.0 - fractionAbove;
+        return static_cast<float>(fractionBelow * _waveTable[indexBelow] + fractionAbove * _waveTable[indexAbove]);
+    }
+
+    void advance(int frames) {
+        _phase = std::fmod(_phase + frames * _phaseIncrement, WAVETABLE_LENGTH);
+        if (_phase < 0) {
+            _phase += WAVETABLE_LENGTH;
+        }
+    }
 
     float nextSample() {
-        return _oscillator.nextSample({{_waveTable, 1.0}});
+        auto sample = value();
+        advance(1);
+        return sample;
     }
 
-    Oscillator _oscillator;
-    WaveTable _waveTable;
+    double _sampleRate;
+    double _phase;
+    double _phaseIncrement;
+    const WaveTable& _waveTable;
 };
 
 LowFrequencyOscillator::LowFrequencyOscillator(double frequency, double sampleRate) :
@@ -54,6 +89,18 @@ LowFrequencyOscillator& LowFrequencyOscillator::operator=(LowFrequencyOscillator
     return *this;
 }
 
+void LowFrequencyOscillator::setFrequency(double frequency) {
+    _impl->setFrequency(frequency);
+}
+
+float LowFrequencyOscillator::value() const {
+    return _impl->value();
+}
+
+void LowFrequencyOscillator::advance(int frames) {
+    _impl->advance(frames);
+}
+
 float LowFrequencyOscillator::nextSample() {
     return _impl->nextSample();
 }
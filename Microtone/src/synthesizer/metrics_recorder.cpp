@@ -0,0 +1,83 @@
+#include <synthesizer/metrics_recorder.hpp>
+
+namespace microtone {
+
+namespace {
+
+int renderTimeBucket(std::chrono::nanoseconds renderTime) {
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(renderTime).count();
+    auto bucket = 0;
+    while (micros > 1 && bucket < RENDER_TIME_BUCKET_COUNT - 1) {
+        micros >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+}
+
+std::chrono::microseconds renderTimeBucketLimit(int bucket) {
+    return std::chrono::microseconds{std::int64_t{2} << bucket};
+}
+
+MetricsRecorder::MetricsRecorder() :
+    _renderTimeHistogram{},
+    _lastRenderTime{0},
+    _maxRenderTime{0},
+    _deadline{0},
+    _renderCount{0},
+    _deadlineMisses{0},
+    _activeVoices{0},
+    _peakActiveVoices{0},
+    _eventsProcessed{0},
+    _lastBlockEvents{0},
+    _peakBlockEvents{0},
+    _droppedEvents{0} {
+}
+
+void MetricsRecorder::recordRender(std::chrono::nanoseconds renderTime,
+                                   std::chrono::nanoseconds deadline,
+                                   int events,
+                                   int activeVoices,
+                                   int peakActiveVoices) {
+    add(_renderTimeHistogram[renderTimeBucket(renderTime)], std::uint64_t{1});
+    _lastRenderTime.store(renderTime.count(), std::memory_order_relaxed);
+    raise(_maxRenderTime, static_cast<std::int64_t>(renderTime.count()));
+    _deadline.store(deadline.count(), std::memory_order_relaxed);
+    add(_renderCount, std::uint64_t{1});
+    if (renderTime > deadline) {
+        add(_deadlineMisses, std::uint64_t{1});
+    }
+
+    _activeVoices.store(activeVoices, std::memory_order_relaxed);
+    raise(_peakActiveVoices, peakActiveVoices);
+
+    add(_eventsProcessed, static_cast<std::uint64_t>(events));
+    _lastBlockEvents.store(events, std::memory_order_relaxed);
+    raise(_peakBlockEvents, events);
+}
+
+void MetricsRecorder::countDroppedEvent() {
+    _droppedEvents.fetch_add(1, std::memory_order_relaxed);
+}
+
+SynthesizerMetrics MetricsRecorder::read() const {
+    auto metrics = SynthesizerMetrics{};
+    for (auto bucket = 0; bucket < RENDER_TIME_BUCKET_COUNT; ++bucket) {
+        metrics.renderTimeHistogram[bucket] = _renderTimeHistogram[bucket].load(std::memory_order_relaxed);
+    }
+    metrics.lastRenderTime = std::chrono::nanoseconds{_lastRenderTime.load(std::memory_order_relaxed)};
+    metrics.maxRenderTime = std::chrono::nanoseconds{_maxRenderTime.load(std::memory_order_relaxed)};
+    metrics.deadline = std::chrono::nanoseconds{_deadline.load(std::memory_order_relaxed)};
+    metrics.renderCount = _renderCount.load(std::memory_order_relaxed);
+    metrics.deadlineMisses = _deadlineMisses.load(std::memory_order_relaxed);
+    metrics.activeVoices = _activeVoices.load(std::memory_order_relaxed);
+    metrics.peakActiveVoices = _peakActiveVoices.load(std::memory_order_relaxed);
+    metrics.eventsProcessed = _eventsProcessed.load(std::memory_order_relaxed);
+    metrics.lastBlockEvents = _lastBlockEvents.load(std::memory_order_relaxed);
+    metrics.peakBlockEvents = _peakBlockEvents.load(std::memory_order_relaxed);
+    metrics.droppedEvents = _droppedEvents.load(std::memory_order_relaxed);
+    return metrics;
+}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <microtone/synthesizer/metrics.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace microtone {
+
+// Counters the audio thread updates once per render() call and any thread can read. The
+// audio thread is the only writer of everything but the dropped event count, so it updates
+// with plain relaxed stores rather than read-modify-writes.
+class MetricsRecorder {
+public:
+    MetricsRecorder();
+    MetricsRecorder(const MetricsRecorder&) = delete;
+    MetricsRecorder& operator=(const MetricsRecorder&) = delete;
+
+    // The audio thread only.
+    void recordRender(std::chrono::nanoseconds renderTime,
+                      std::chrono::nanoseconds deadline,
+                      int events,
+                      int activeVoices,
+                      int peakActiveVoices);
+
+    // Any thread.
+    void countDroppedEvent();
+
+    // Fills in everything but the audio backend's counters.
+    SynthesizerMetrics read() const;
+
+private:
+    template <typename T>
+    static void add(std::atomic<T>& counter, T value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    template <typename T>
+    static void raise(std::atomic<T>& peak, T value) {
+        if (value > peak.load(std::memory_order_relaxed)) {
+            peak.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    std::array<std::atomic<std::uint64_t>, RENDER_TIME_BUCKET_COUNT> _renderTimeHistogram;
+    std::atomic<std::int64_t> _lastRenderTime;    // In nanoseconds, like the two below.
+    std::atomic<std::int64_t> _maxRenderTime;
+    std::atomic<std::int64_t> _deadline;
+    std::atomic<std::uint64_t> _renderCount;
+    std::atomic<std::uint64_t> _deadlineMisses;
+    std::atomic<int> _activeVoices;
+    std::atomic<int> _peakActiveVoices;
+    std::atomic<std::uint64_t> _eventsProcessed;
+    std::atomic<int> _lastBlockEvents;
+    std::atomic<int> _peakBlockEvents;
+    alignas(64) std::atomic<std::uint64_t> _droppedEvents;    // Written by MIDI threads, kept off the audio thread's line.
+};
+
+}
@@ -1,44 +1,53 @@
 #include <microtone/exception.hpp>
 #include <microtone/log.hpp>
+#include <microtone/synthesizer/audio_buffer.hpp>
 #include <microtone/synthesizer/oscillator.hpp>
+#include <microtone/synthesizer/oscillator_kernel.hpp>
 
+#include <algorithm>
 #include <array>
-#include <cmath>
 
 namespace microtone {
 
 class Oscillator::impl {
 public:
     impl(double frequency, double sampleRate) :
-        _frequency{frequency},
-        _sampleRate{sampleRate},
-        _currentIndex{0} {}
+        _phase{0},
+        _phaseIncrement{phaseIncrement(frequency, sampleRate)},
+        _kernel{oscillatorKernel(bestOscillatorKernel())} {}
 
     impl(const impl& other) :
-        _frequency{other._frequency},
-        _sampleRate{other._sampleRate},
-        _currentIndex{0} {
+        _phase{0},
+        _phaseIncrement{other._phaseIncrement},
+        _kernel{other._kernel} {
     }
 
-    float nextSample(const std::vector<WeightedWaveTable>& weightedWaveTables) {
-        // Linear interpolation improves the signal approximation accuracy at discrete index.
-        auto indexBelow = static_cast<int>(floor(_currentIndex));
-        auto indexAbove = (indexBelow + 1) % WAVETABLE_LENGTH;
-        auto fractionAbove = _currentIndex - indexBelow;
-        auto fractionBelow = 1.0 - fractionAbove;
-        _currentIndex = std::fmod((_currentIndex + WAVETABLE_LENGTH * _frequency / _sampleRate), WAVETABLE_LENGTH);
-
-        auto nextSample = 0.0f;
-        for (const auto& weightedWaveTable : weightedWaveTables) {
-            nextSample += (fractionBelow * weightedWaveTable.waveTable[indexBelow] + fractionAbove * weightedWaveTable.waveTable[indexAbove]) * weightedWaveTable.weight;
+    void processBlock(const std::vector<WeightedWaveTable>& weightedWaveTables, float* out, int frames) {
+        // Scratch space on the stack, deliberately left uninitialized.
+        AudioBuffer tableBuffer;
+
+        while (frames > 0) {
+            auto blockFrames = std::min(frames, FRAMES_PER_BUFFER);
+            // Overflow wraps the phase back round the table.
+            auto nextPhase = _phase + static_cast<OscillatorPhase>(blockFrames) * _phaseIncrement;
+            std::fill(out, out + blockFrames, 0.0f);
+            for (const auto& weightedWaveTable : weightedWaveTables) {
+                nextPhase = _kernel(weightedWaveTable.waveTable.data(), _phase, _phaseIncrement, tableBuffer.data(), blockFrames);
+                const auto weight = static_cast<float>(weightedWaveTable.weight);
+                for (auto frame = 0; frame < blockFrames; ++frame) {
+                    out[frame] += weight * tableBuffer[frame];
+                }
+            }
+            _phase = nextPhase;
+
+            out += blockFrames;
+            frames -= blockFrames;
         }
-
-        return nextSample;
     }
 
-    double _frequency;
-    double _sampleRate;
-    double _currentIndex;
+    OscillatorPhase _phase;
+    OscillatorPhase _phaseIncrement;             // Worked out once, for the oscillator's frequency.
+    OscillatorKernelFn _kernel;
 };
 
 Oscillator::Oscillator(double frequency, double sampleRate) :
@@ -68,7 +77,13 @@ Oscillator& Oscillator::operator=(Oscillator&& other) noexcept {
 Oscillator::~Oscillator() = default;
 
 float Oscillator::nextSample(const std::vector<WeightedWaveTable>& weightedWaveTables) {
-    return _impl->nextSample(weightedWaveTables);
+    auto sample = 0.0f;
+    _impl->processBlock(weightedWaveTables, &sample, 1);
+    return sample;
+}
+
+void Oscillator::processBlock(const std::vector<WeightedWaveTable>& weightedWaveTables, float* out, int frames) {
+    _impl->processBlock(weightedWaveTables, out, frames);
 }
 
 }
@@ -0,0 +1,242 @@
+#include <microtone/synthesizer/oscillator_kernel.hpp>
+#include <microtone/synthesizer/wavetable.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define MICROTONE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MICROTONE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MICROTONE_TARGET(isa)
+#endif
+
+namespace microtone {
+
+namespace {
+
+// The top bits of a phase index the table, the rest are the fraction between two samples.
+const int PHASE_INDEX_BITS = 9;
+const int PHASE_FRACTION_BITS = 32 - PHASE_INDEX_BITS;
+const int WAVETABLE_MASK = WAVETABLE_LENGTH - 1;
+const int PHASE_FRACTION_MASK = (1 << PHASE_FRACTION_BITS) - 1;
+const float PHASE_FRACTION_SCALE = 1.0f / (1 << PHASE_FRACTION_BITS);
+const double PHASES_PER_CYCLE = 4294967296.0;
+
+static_assert(1 << PHASE_INDEX_BITS == WAVETABLE_LENGTH, "A phase's index bits must cover the table exactly.");
+
+// The reference every other kernel is checked against.
+OscillatorPhase scalarKernel(const float* table, OscillatorPhase phase, OscillatorPhase increment, float* out, int frames) {
+    for (auto frame = 0; frame < frames; ++frame) {
+        // Linear interpolation improves the signal approximation accuracy at discrete index.
+        auto indexBelow = phase >> PHASE_FRACTION_BITS;
+        auto indexAbove = (indexBelow + 1) & WAVETABLE_MASK;
+        auto fraction = static_cast<float>(phase & PHASE_FRACTION_MASK) * PHASE_FRACTION_SCALE;
+        out[frame] = table[indexBelow] + fraction * (table[indexAbove] - table[indexBelow]);
+        phase += increment;
+    }
+    return phase;
+}
+
+#ifdef MICROTONE_X86
+
+// Lane phases start a sample apart and every lane steps by the vector width, all in
+// wrapping 32-bit integer arithmetic, so there's no float drift and no wraparound check.
+
+MICROTONE_TARGET("sse2")
+OscillatorPhase sse2Kernel(const float* table, OscillatorPhase phase, OscillatorPhase increment, float* out, int frames) {
+    const auto step = _mm_set1_epi32(static_cast<int>(4 * increment));
+    const auto fractionMask = _mm_set1_epi32(PHASE_FRACTION_MASK);
+    const auto fractionScale = _mm_set1_ps(PHASE_FRACTION_SCALE);
+    const auto mask = _mm_set1_epi32(WAVETABLE_MASK);
+    const auto one = _mm_set1_epi32(1);
+    auto phases = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(phase)),
+                                _mm_set_epi32(static_cast<int>(3 * increment), static_cast<int>(2 * increment), static_cast<int>(increment), 0));
+    alignas(16) std::int32_t below[4];
+    alignas(16) std::int32_t above[4];
+
+    auto frame = 0;
+    for (; frame + 4 <= frames; frame += 4) {
+        auto indices = _mm_srli_epi32(phases, PHASE_FRACTION_BITS);
+        auto fractions = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(phases, fractionMask)), fractionScale);
+        _mm_store_si128(reinterpret_cast<__m128i*>(below), indices);
+        _mm_store_si128(reinterpret_cast<__m128i*>(above), _mm_and_si128(_mm_add_epi32(indices, one), mask));
+
+        auto samplesBelow = _mm_set_ps(table[below[3]], table[below[2]], table[below[1]], table[below[0]]);
+        auto samplesAbove = _mm_set_ps(table[above[3]], table[above[2]], table[above[1]], table[above[0]]);
+        _mm_storeu_ps(out + frame, _mm_add_ps(samplesBelow, _mm_mul_ps(fractions, _mm_sub_ps(samplesAbove, samplesBelow))));
+
+        phases = _mm_add_epi32(phases, step);
+    }
+    phase += static_cast<OscillatorPhase>(frame) * increment;
+    return scalarKernel(table, phase, increment, out + frame, frames - frame);
+}
+
+MICROTONE_TARGET("avx2,fma")
+OscillatorPhase avx2Kernel(const float* table, OscillatorPhase phase, OscillatorPhase increment, float* out, int frames) {
+    const auto step = _mm256_set1_epi32(static_cast<int>(8 * increment));
+    const auto fractionMask = _mm256_set1_epi32(PHASE_FRACTION_MASK);
+    const auto fractionScale = _mm256_set1_ps(PHASE_FRACTION_SCALE);
+    const auto mask = _mm256_set1_epi32(WAVETABLE_MASK);
+    const auto one = _mm256_set1_epi32(1);
+    auto phases = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(phase)),
+                                   _mm256_mullo_epi32(_mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0), _mm256_set1_epi32(static_cast<int>(increment))));
+
+    auto frame = 0;
+    for (; frame + 8 <= frames; frame += 8) {
+        auto indices = _mm256_srli_epi32(phases, PHASE_FRACTION_BITS);
+        auto fractions = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(phases, fractionMask)), fractionScale);
+        auto samplesBelow = _mm256_i32gather_ps(table, indices, 4);
+        auto samplesAbove = _mm256_i32gather_ps(table, _mm256_and_si256(_mm256_add_epi32(indices, one), mask), 4);
+        _mm256_storeu_ps(out + frame, _mm256_fmadd_ps(fractions, _mm256_sub_ps(samplesAbove, samplesBelow), samplesBelow));
+
+        phases = _mm256_add_epi32(phases, step);
+    }
+    phase += static_cast<OscillatorPhase>(frame) * increment;
+    // The compiler turns the call below into a jump without clearing the upper halves of
+    // the vector registers, which slows the scalar code after it many times over; ruinous
+    // for the one-sample blocks of per-sample modulation.
+    _mm256_zeroupper();
+    return scalarKernel(table, phase, increment, out + frame, frames - frame);
+}
+
+MICROTONE_TARGET("avx512f")
+OscillatorPhase avx512Kernel(const float* table, OscillatorPhase phase, OscillatorPhase increment, float* out, int frames) {
+    const auto step = _mm512_set1_epi32(static_cast<int>(16 * increment));
+    const auto fractionMask = _mm512_set1_epi32(PHASE_FRACTION_MASK);
+    const auto fractionScale = _mm512_set1_ps(PHASE_FRACTION_SCALE);
+    const auto mask = _mm512_set1_epi32(WAVETABLE_MASK);
+    const auto one = _mm512_set1_epi32(1);
+    auto phases = _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(phase)),
+                                   _mm512_mullo_epi32(_mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0),
+                                                      _mm512_set1_epi32(static_cast<int>(increment))));
+
+    // GCC's unmasked forms of these pass an undefined vector through, which it then warns may
+    // be uninitialized. The masked forms with every lane set are the same instructions.
+    const auto lanes = static_cast<__mmask16>(0xFFFF);
+    const auto zero = _mm512_setzero_ps();
+
+    auto frame = 0;
+    for (; frame + 16 <= frames; frame += 16) {
+        auto indices = _mm512_maskz_srli_epi32(lanes, phases, PHASE_FRACTION_BITS);
+        auto fractions = _mm512_mul_ps(_mm512_maskz_cvtepi32_ps(lanes, _mm512_and_si512(phases, fractionMask)), fractionScale);
+        auto samplesBelow = _mm512_mask_i32gather_ps(zero, lanes, indices, table, 4);
+        auto samplesAbove = _mm512_mask_i32gather_ps(zero, lanes, _mm512_and_si512(_mm512_add_epi32(indices, one), mask), table, 4);
+        _mm512_storeu_ps(out + frame, _mm512_fmadd_ps(fractions, _mm512_sub_ps(samplesAbove, samplesBelow), samplesBelow));
+
+        phases = _mm512_add_epi32(phases, step);
+    }
+    phase += static_cast<OscillatorPhase>(frame) * increment;
+    _mm256_zeroupper();
+    return scalarKernel(table, phase, increment, out + frame, frames - frame);
+}
+
+bool cpuSupports(OscillatorKernel kernel) {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    auto maxLeaf = info[0];
+    __cpuid(info, 1);
+    auto osAvx = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+    auto extended = std::int32_t{0};
+    if (maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        extended = info[1];
+    }
+    switch (kernel) {
+    case OscillatorKernel::Scalar:
+    case OscillatorKernel::Sse2:
+        return true;
+    case OscillatorKernel::Avx2:
+        return osAvx && (extended & (1 << 5)) != 0;
+    case OscillatorKernel::Avx512:
+        return osAvx && (_xgetbv(0) & 0xe6) == 0xe6 && (extended & (1 << 16)) != 0;
+    }
+    return false;
+#else
+    __builtin_cpu_init();
+    switch (kernel) {
+    case OscillatorKernel::Scalar:
+        return true;
+    case OscillatorKernel::Sse2:
+        return __builtin_cpu_supports("sse2");
+    case OscillatorKernel::Avx2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case OscillatorKernel::Avx512:
+        return __builtin_cpu_supports("avx512f");
+    }
+    return false;
+#endif
+}
+
+#else
+
+bool cpuSupports(OscillatorKernel kernel) {
+    return kernel == OscillatorKernel::Scalar;
+}
+
+#endif
+
+}
+
+OscillatorPhase phaseIncrement(double frequency, double sampleRate) {
+    auto cyclesPerSample = std::clamp(frequency / sampleRate, 0.0, 0.5);
+    return static_cast<OscillatorPhase>(std::llround(cyclesPerSample * PHASES_PER_CYCLE));
+}
+
+OscillatorKernelFn oscillatorKernel(OscillatorKernel kernel) {
+    if (!cpuSupports(kernel)) {
+        return nullptr;
+    }
+
+    switch (kernel) {
+    case OscillatorKernel::Scalar:
+        return &scalarKernel;
+#ifdef MICROTONE_X86
+    case OscillatorKernel::Sse2:
+        return &sse2Kernel;
+    case OscillatorKernel::Avx2:
+        return &avx2Kernel;
+    case OscillatorKernel::Avx512:
+        return &avx512Kernel;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+OscillatorKernel bestOscillatorKernel() {
+    static const auto best = [] {
+        for (auto kernel : {OscillatorKernel::Avx512, OscillatorKernel::Avx2, OscillatorKernel::Sse2}) {
+            if (oscillatorKernel(kernel)) {
+                return kernel;
+            }
+        }
+        return OscillatorKernel::Scalar;
+    }();
+    return best;
+}
+
+std::string oscillatorKernelName(OscillatorKernel kernel) {
+    switch (kernel) {
+    case OscillatorKernel::Scalar:
+        return "scalar";
+    case OscillatorKernel::Sse2:
+        return "sse2";
+    case OscillatorKernel::Avx2:
+        return "avx2";
+    case OscillatorKernel::Avx512:
+        return "avx512";
+    }
+    return "unknown";
+}
+
+}
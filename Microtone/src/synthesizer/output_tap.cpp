@@ -0,0 +1,125 @@
+#include <microtone/synthesizer/output_tap.hpp>
+
+#include <synthesizer/output_tap.hpp>
+
+#include <algorithm>
+
+namespace microtone {
+
+static_assert((OUTPUT_TAP_CAPACITY & (OUTPUT_TAP_CAPACITY - 1)) == 0, "The tap wraps positions with a mask.");
+
+OutputTap::OutputTap() :
+    _samples{},
+    _claimedPosition{0},
+    _writtenPosition{0} {
+}
+
+void OutputTap::write(const float* samples, std::size_t frames) {
+    auto position = _writtenPosition.load(std::memory_order_relaxed);
+    while (frames > 0) {
+        auto chunkFrames = std::min(frames, OUTPUT_TAP_CAPACITY);
+
+        // Readers that see any of these samples also see the claim, so they know to discard
+        // what they copied from the slots being overwritten.
+        _claimedPosition.store(position + chunkFrames, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t frame = 0; frame < chunkFrames; ++frame) {
+            _samples[(position + frame) & MASK].store(samples[frame], std::memory_order_relaxed);
+        }
+        position += chunkFrames;
+        _writtenPosition.store(position, std::memory_order_release);
+
+        samples += chunkFrames;
+        frames -= chunkFrames;
+    }
+}
+
+std::uint64_t OutputTap::writePosition() const {
+    return _writtenPosition.load(std::memory_order_acquire);
+}
+
+std::size_t OutputTap::copy(std::uint64_t position, float* out, std::size_t frames) const {
+    for (std::size_t frame = 0; frame < frames; ++frame) {
+        out[frame] = _samples[(position + frame) & MASK].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    // Everything before claimed - capacity may have been overwritten under us.
+    auto claimed = _claimedPosition.load(std::memory_order_relaxed);
+    if (claimed <= position + OUTPUT_TAP_CAPACITY) {
+        return 0;
+    }
+    return static_cast<std::size_t>(std::min<std::uint64_t>(claimed - OUTPUT_TAP_CAPACITY - position, frames));
+}
+
+class OutputTapReader::impl {
+public:
+    explicit impl(std::shared_ptr<const OutputTap> tap) :
+        _tap{std::move(tap)},
+        _position{_tap->writePosition()},
+        _droppedFrames{0} {
+    }
+
+    std::size_t read(float* out, std::size_t frames) {
+        auto writePosition = _tap->writePosition();
+        if (writePosition - _position > OUTPUT_TAP_CAPACITY) {
+            skipTo(writePosition - OUTPUT_TAP_CAPACITY);
+        }
+
+        auto count = static_cast<std::size_t>(std::min<std::uint64_t>(frames, writePosition - _position));
+        auto overwritten = _tap->copy(_position, out, count);
+        if (overwritten > 0) {
+            std::copy(out + overwritten, out + count, out);
+            _droppedFrames += overwritten;
+            count -= overwritten;
+        }
+        _position += overwritten + count;
+        return count;
+    }
+
+    std::size_t readLatest(float* out, std::size_t frames) {
+        auto writePosition = _tap->writePosition();
+        _position = std::max(_position, writePosition - std::min<std::uint64_t>(frames, writePosition));
+        return read(out, frames);
+    }
+
+    void skipTo(std::uint64_t position) {
+        _droppedFrames += position - _position;
+        _position = position;
+    }
+
+    std::shared_ptr<const OutputTap> _tap;
+    std::uint64_t _position;
+    std::uint64_t _droppedFrames;
+};
+
+OutputTapReader::OutputTapReader(std::shared_ptr<const OutputTap> tap) :
+    _impl{new impl{std::move(tap)}} {
+}
+
+OutputTapReader::OutputTapReader(OutputTapReader&& other) noexcept :
+    _impl{std::move(other._impl)} {
+}
+
+OutputTapReader& OutputTapReader::operator=(OutputTapReader&& other) noexcept {
+    if (this != &other) {
+        _impl = std::move(other._impl);
+    }
+    return *this;
+}
+
+OutputTapReader::~OutputTapReader() = default;
+
+std::size_t OutputTapReader::read(float* out, std::size_t frames) {
+    return _impl->read(out, frames);
+}
+
+std::size_t OutputTapReader::readLatest(float* out, std::size_t frames) {
+    return _impl->readLatest(out, frames);
+}
+
+std::uint64_t OutputTapReader::droppedFrames() const {
+    return _impl->_droppedFrames;
+}
+
+}
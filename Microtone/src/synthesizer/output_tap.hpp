@@ -0,0 +1,40 @@
+#pragma once
+
+#include <microtone/synthesizer/output_tap.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace microtone {
+
+// About 1.4 seconds at 48kHz.
+const std::size_t OUTPUT_TAP_CAPACITY = std::size_t{1} << 16;
+
+// Single-writer ring buffer of output samples. The writer never waits; readers check after
+// copying whether the writer lapped them, the way a seqlock reader does.
+class OutputTap {
+public:
+    OutputTap();
+    OutputTap(const OutputTap&) = delete;
+    OutputTap& operator=(const OutputTap&) = delete;
+
+    // The audio thread only.
+    void write(const float* samples, std::size_t frames);
+
+    // Samples written so far.
+    std::uint64_t writePosition() const;
+    // Copies the samples at [position, position + frames), which must already be written.
+    // Returns how many of the leading samples may have been overwritten while copying.
+    std::size_t copy(std::uint64_t position, float* out, std::size_t frames) const;
+
+private:
+    static constexpr std::size_t MASK = OUTPUT_TAP_CAPACITY - 1;
+
+    std::array<std::atomic<float>, OUTPUT_TAP_CAPACITY> _samples;
+    alignas(64) std::atomic<std::uint64_t> _claimedPosition;    // Where the current write ends.
+    alignas(64) std::atomic<std::uint64_t> _writtenPosition;    // Where the last finished write ends.
+};
+
+}
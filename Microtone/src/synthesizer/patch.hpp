@@ -0,0 +1,40 @@
+#pragma once
+
+#include <microtone/synthesizer/envelope.hpp>
+#include <microtone/synthesizer/filter.hpp>
+#include <microtone/synthesizer/modulation.hpp>
+#include <microtone/synthesizer/polyphony.hpp>
+
+#include <synthesizer/band_limited_wavetable.hpp>
+#include <synthesizer/tuning_table.hpp>
+
+#include <array>
+#include <memory>
+
+namespace microtone {
+
+// Every sound parameter the audio thread reads, published as one immutable snapshot.
+struct Patch {
+    std::shared_ptr<const BandLimitedWaveTable> waveTable;
+    std::shared_ptr<const TuningTable> tuning;
+    double attack{0.01};
+    double decay{0.1};
+    double sustain{0.8};
+    double release{0.01};
+    EnvelopeCurve envelopeCurve{EnvelopeCurve::Linear};
+    FilterMode filterMode{FilterMode::LowPass};
+    FilterTopology filterTopology{FilterTopology::StateVariable};
+    double filterCutoff{DEFAULT_FILTER_CUTOFF};
+    double filterResonance{DEFAULT_FILTER_RESONANCE};
+    int polyphony{DEFAULT_POLYPHONY};
+    VoiceStealingPolicy voiceStealingPolicy{VoiceStealingPolicy::ReleasedFirst};
+    std::array<double, LFO_COUNT> lfoFrequencies{5.0, 0.5};
+    std::array<ModulationRoute, MAX_MODULATION_ROUTES> modulationRoutes{};
+    int modulationRouteCount{0};
+    int controlRate{DEFAULT_CONTROL_RATE};
+    double pitchBendRange{DEFAULT_PITCH_BEND_RANGE};
+    bool mpe{false};
+    double mpePitchBendRange{DEFAULT_MPE_PITCH_BEND_RANGE};
+};
+
+}
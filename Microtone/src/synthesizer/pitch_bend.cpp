@@ -0,0 +1,49 @@
+#include <synthesizer/pitch_bend.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace microtone {
+
+namespace {
+
+const int RATIO_STEPS = 256;            // Per octave.
+const double CENTS_PER_OCTAVE = 1200;
+// Past this, any increment is either 0 or over Nyquist.
+const double MAX_OCTAVES = 32;
+const double MAX_INCREMENT = 2147483648.0;  // Half a cycle.
+
+// 2^(step / RATIO_STEPS) across one octave, with one more step to interpolate towards.
+using OctaveRatios = std::array<double, RATIO_STEPS + 1>;
+
+OctaveRatios makeOctaveRatios() {
+    auto ratios = OctaveRatios{};
+    for (auto step = 0; step <= RATIO_STEPS; ++step) {
+        ratios[step] = std::exp2(static_cast<double>(step) / RATIO_STEPS);
+    }
+    return ratios;
+}
+
+// Built before main, so the audio thread never waits on it.
+const OctaveRatios OCTAVE_RATIOS = makeOctaveRatios();
+
+}
+
+OscillatorPhase bendPhaseIncrement(OscillatorPhase increment, float cents) {
+    if (cents == 0.0f) {
+        return increment;
+    }
+
+    auto position = std::clamp(cents / CENTS_PER_OCTAVE, -MAX_OCTAVES, MAX_OCTAVES) * RATIO_STEPS;
+    auto floor = std::floor(position);
+    auto step = static_cast<int>(floor);
+    // Whole octaves are exact powers of two; the table covers the rest.
+    auto octaves = step >= 0 ? step / RATIO_STEPS : -((RATIO_STEPS - 1 - step) / RATIO_STEPS);
+    step -= octaves * RATIO_STEPS;
+    auto ratio = OCTAVE_RATIOS[step] + (OCTAVE_RATIOS[step + 1] - OCTAVE_RATIOS[step]) * (position - floor);
+    auto bent = std::ldexp(increment * ratio, octaves);
+    return static_cast<OscillatorPhase>(std::min(bent, MAX_INCREMENT) + 0.5);
+}
+
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <microtone/synthesizer/oscillator_kernel.hpp>
+
+namespace microtone {
+
+// increment moved by cents, held below Nyquist like phaseIncrement(). Looks the ratio up in a
+// table instead of calling exp2, so voices can follow bends and pitch modulation every
+// control period. Accurate to within a hundredth of a cent.
+OscillatorPhase bendPhaseIncrement(OscillatorPhase increment, float cents);
+
+}
@@ -0,0 +1,169 @@
+#include <microtone/log.hpp>
+#include <microtone/realtime_check.hpp>
+
+#include <synthesizer/render_pool.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <mach/thread_policy.h>
+#include <pthread.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace microtone {
+
+namespace {
+
+// Workers yield for a while after each block before going to sleep, so back-to-back
+// blocks don't pay for a wake up.
+const int SPIN_COUNT = 1000;
+// Sleeping workers recheck this often in case a wake up raced with going to sleep.
+const auto SLEEP_INTERVAL = std::chrono::milliseconds(1);
+
+void pinToCore(std::thread& thread, int core) {
+#if defined(__linux__)
+    auto cpus = cpu_set_t{};
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    if (pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus) != 0) {
+        M_WARN("Couldn't pin render thread to core {}.", core);
+    }
+#elif defined(__APPLE__)
+    // macOS doesn't pin threads; distinct affinity tags ask the scheduler to keep them apart.
+    auto policy = thread_affinity_policy_data_t{core + 1};
+    thread_policy_set(pthread_mach_thread_np(thread.native_handle()),
+                      THREAD_AFFINITY_POLICY,
+                      reinterpret_cast<thread_policy_t>(&policy),
+                      THREAD_AFFINITY_POLICY_COUNT);
+#elif defined(_WIN32)
+    if (SetThreadAffinityMask(thread.native_handle(), DWORD_PTR{1} << core) == 0) {
+        M_WARN("Couldn't pin render thread to core {}.", core);
+    }
+#else
+    (void)thread;
+    (void)core;
+#endif
+}
+
+}
+
+RenderPool::RenderPool(int threadCount) :
+    _threadCount{std::max(threadCount, 1)},
+    _queues{new TaskRange[static_cast<std::size_t>(_threadCount)]},
+    _context{nullptr},
+    _taskFn{nullptr},
+    _completedTasks{0},
+    _generation{0},
+    _stopping{false} {
+    auto cores = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+    for (auto thread = 1; thread < _threadCount; ++thread) {
+        _workers.emplace_back([this, thread] {
+            workerLoop(thread);
+        });
+        pinToCore(_workers.back(), thread % cores);
+    }
+}
+
+RenderPool::~RenderPool() {
+    {
+        auto lockGaurd = std::unique_lock<std::mutex>{_wakeMutex};
+        _stopping.store(true);
+    }
+    _wakeCondition.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+int RenderPool::threadCount() const {
+    return _threadCount;
+}
+
+void RenderPool::runTasks(int taskCount, void* context, TaskFn fn) {
+    if (taskCount <= 0) {
+        return;
+    }
+
+    // Every claim happens after the ranges below are published, so workers see these.
+    _context = context;
+    _taskFn = fn;
+    _completedTasks.store(0, std::memory_order_relaxed);
+    for (auto thread = 0; thread < _threadCount; ++thread) {
+        auto first = static_cast<std::uint64_t>(taskCount) * thread / _threadCount;
+        auto end = static_cast<std::uint64_t>(taskCount) * (thread + 1) / _threadCount;
+        _queues[thread].range.store(end << 32 | first, std::memory_order_release);
+    }
+
+    _generation.fetch_add(1, std::memory_order_release);
+    // Doesn't take the mutex; a worker that misses this wakes up on its own shortly.
+    _wakeCondition.notify_all();
+
+    runAvailableTasks(0);
+
+    // Whatever is left was claimed by a worker that's running it right now.
+    while (_completedTasks.load(std::memory_order_acquire) < taskCount) {
+        std::this_thread::yield();
+    }
+}
+
+void RenderPool::runAvailableTasks(int thread) {
+    auto task = 0;
+    for (auto offset = 0; offset < _threadCount; ++offset) {
+        auto queue = (thread + offset) % _threadCount;
+        while (claimTask(queue, task)) {
+            _taskFn(_context, task, thread);
+            _completedTasks.fetch_add(1, std::memory_order_release);
+        }
+    }
+}
+
+bool RenderPool::claimTask(int queue, int& task) {
+    auto& range = _queues[queue].range;
+    auto current = range.load(std::memory_order_acquire);
+    while (true) {
+        auto next = static_cast<std::uint32_t>(current);
+        auto end = static_cast<std::uint32_t>(current >> 32);
+        if (next >= end) {
+            return false;
+        }
+        if (range.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel)) {
+            task = static_cast<int>(next);
+            return true;
+        }
+    }
+}
+
+void RenderPool::workerLoop(int thread) {
+    auto seenGeneration = std::uint32_t{0};
+    while (true) {
+        auto spins = 0;
+        while (_generation.load(std::memory_order_acquire) == seenGeneration && !_stopping.load()) {
+            if (++spins < SPIN_COUNT) {
+                std::this_thread::yield();
+            } else {
+                auto lock = std::unique_lock<std::mutex>{_wakeMutex};
+                _wakeCondition.wait_for(lock, SLEEP_INTERVAL, [this, seenGeneration] {
+                    return _generation.load() != seenGeneration || _stopping.load();
+                });
+            }
+        }
+
+        if (_stopping.load()) {
+            return;
+        }
+
+        seenGeneration = _generation.load(std::memory_order_acquire);
+        auto realtimeScope = RealtimeScope{};
+        runAvailableTasks(thread);
+    }
+}
+
+}
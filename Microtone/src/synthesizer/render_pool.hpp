@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace microtone {
+
+// Runs one block's worth of independent tasks across worker threads pinned to their own
+// cores. Every thread starts on its own share of the tasks and steals from the others once
+// that runs dry. The calling (audio) thread works too, so a worker that wakes late only
+// costs parallelism, never the deadline. run() never locks or allocates.
+class RenderPool {
+public:
+    // threadCount includes the calling thread.
+    explicit RenderPool(int threadCount);
+    RenderPool(const RenderPool&) = delete;
+    RenderPool& operator=(const RenderPool&) = delete;
+    ~RenderPool();
+
+    int threadCount() const;
+
+    // Calls fn(task, thread) for every task in [0, taskCount) and returns once all of them
+    // are done. thread is in [0, threadCount()), 0 being the caller, so tasks can write to
+    // per-thread scratch space without sharing it.
+    template <typename Fn>
+    void run(int taskCount, Fn& fn) {
+        runTasks(taskCount, &fn, [](void* context, int task, int thread) {
+            (*static_cast<Fn*>(context))(task, thread);
+        });
+    }
+
+private:
+    using TaskFn = void (*)(void* context, int task, int thread);
+
+    // The unclaimed tasks of one thread, packed as (end << 32 | next) so a claim is one CAS.
+    struct alignas(64) TaskRange {
+        std::atomic<std::uint64_t> range{0};
+    };
+
+    void runTasks(int taskCount, void* context, TaskFn fn);
+    void runAvailableTasks(int thread);
+    bool claimTask(int queue, int& task);
+    void workerLoop(int thread);
+
+    int _threadCount;
+    std::unique_ptr<TaskRange[]> _queues;
+    void* _context;
+    TaskFn _taskFn;
+    alignas(64) std::atomic<int> _completedTasks;
+    alignas(64) std::atomic<std::uint32_t> _generation;
+    std::atomic<bool> _stopping;
+    std::mutex _wakeMutex;                                  // Taken by sleeping workers only.
+    std::condition_variable _wakeCondition;
+    std::vector<std::thread> _workers;
+};
+
+}
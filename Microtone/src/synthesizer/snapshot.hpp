@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace microtone {
+
+// Hands immutable values from control threads to the audio thread. Writers publish a new
+// value with an atomic pointer swap; the reader picks up the newest value at the start of
+// each block and never blocks, allocates or frees. Replaced values are reclaimed by later
+// writers once the reader has moved on, the way a single hazard pointer works.
+template <typename T>
+class Snapshot {
+public:
+    explicit Snapshot(std::unique_ptr<T> initial) :
+        _latest{initial.get()},
+        _inUse{initial.get()} {
+        _owned.push_back(std::move(initial));
+    }
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    // Control threads.
+    void publish(std::unique_ptr<T> value) {
+        auto lockGaurd = std::unique_lock<std::mutex>{_writerMutex};
+        _latest.store(value.get());
+        _owned.push_back(std::move(value));
+
+        // Everything but the newest value and the one the reader holds can go.
+        auto inUse = _inUse.load();
+        auto latest = _latest.load();
+        _owned.erase(std::remove_if(_owned.begin(),
+                                    _owned.end(),
+                                    [inUse, latest](const std::unique_ptr<T>& owned) {
+                                        return owned.get() != inUse && owned.get() != latest;
+                                    }),
+                     _owned.end());
+    }
+
+    // The audio thread. The returned value stays valid until the next call.
+    const T* acquire() {
+        auto value = _latest.load();
+        while (true) {
+            _inUse.store(value);
+            // A writer that swapped in between may not have seen our claim; retry with its value.
+            auto latest = _latest.load();
+            if (latest == value) {
+                return value;
+            }
+            value = latest;
+        }
+    }
+
+private:
+    std::atomic<T*> _latest;
+    std::atomic<T*> _inUse;
+    std::mutex _writerMutex;                    // Serializes writers only, never taken by the reader.
+    std::vector<std::unique_ptr<T>> _owned;
+};
+
+}
@@ -1,214 +1,537 @@
+#include <microtone/audio_backend.hpp>
 #include <microtone/exception.hpp>
 #include <microtone/log.hpp>
 #include <microtone/midi_input.hpp>
+#include <microtone/realtime_check.hpp>
 #include <microtone/synthesizer/envelope.hpp>
 #include <microtone/synthesizer/filter.hpp>
-#include <microtone/synthesizer/low_frequency_oscillator.hpp>
-#include <microtone/synthesizer/oscillator.hpp>
 #include <microtone/synthesizer/synthesizer.hpp>
-#include <microtone/synthesizer/synthesizer_voice.hpp>
-
-#include <portaudio/portaudio.h>
-#include <rtmidi/RtMidi.h>
-
+#include <microtone/synthesizer/tuning.hpp>
+
+#include <synthesizer/band_limited_wavetable.hpp>
+#include <synthesizer/event_queue.hpp>
+#include <synthesizer/filter_bank.hpp>
+#include <synthesizer/metrics_recorder.hpp>
+#include <synthesizer/output_tap.hpp>
+#include <synthesizer/patch.hpp>
+#include <synthesizer/render_pool.hpp>
+#include <synthesizer/snapshot.hpp>
+#include <synthesizer/tuning_table.hpp>
+#include <synthesizer/voice_allocator.hpp>
+#include <synthesizer/voice_bank.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <memory>
 #include <mutex>
-#include <unordered_set>
 #include <vector>
 
 namespace microtone {
 
-class Synthesizer::impl {
-public:
-    impl(const std::vector<WeightedWaveTable>& weightedWaveTables, OnOutputFn fn) :
-        _onOutputFn{fn},
-        _weightedWaveTables{weightedWaveTables},
-        _activeVoices{},
-        _sustainedVoices{},
-        _voices{},
-        _sustainPedalOn{false},
-        _sampleRate{0} {
-        // Initialize portaudio
-        auto portAudioInitResult = Pa_Initialize();
-        if (portAudioInitResult != paNoError) {
-            throw MicrotoneException(fmt::format("PortAudio error: {}, '{}'.",
-                                                 portAudioInitResult,
-                                                 Pa_GetErrorText(portAudioInitResult)));
-        }
+namespace {
+
+const std::size_t EVENT_QUEUE_CAPACITY = 1024;
+// One SIMD filter group: small enough to balance a handful of notes across threads, large
+// enough that a task outweighs claiming it.
+const int VOICES_PER_TASK = FILTER_LANES;
+const int MAX_RENDER_TASKS = MAX_PARTS * (MAX_VOICES + VOICES_PER_TASK - 1) / VOICES_PER_TASK;
+
+// Note events handed from the MIDI threads to the audio thread. Sound parameters don't go
+// through here; they're published as a Patch snapshot instead.
+struct MidiEvent {
+    int status;
+    int note;
+    int velocity;
+    int frame;                                      // Into the next render() call, or -1 to go by timestamp.
+    std::chrono::steady_clock::time_point timestamp;
+};
 
-        auto deviceId = Pa_GetDefaultOutputDevice();
-        auto outputParameters = PaStreamParameters{};
-        outputParameters.device = deviceId;
-        if (outputParameters.device == paNoDevice) {
-            throw MicrotoneException(fmt::format("Unable to open output device {}.", deviceId));
+// The weighted sum only changes with the weights, so it's baked once here rather than
+// summed per sample per voice.
+WaveTable mixWaveTables(const std::vector<WeightedWaveTable>& weightedWaveTables) {
+    auto mixed = WaveTable{};
+    for (const auto& weightedWaveTable : weightedWaveTables) {
+        for (auto i = 0; i < WAVETABLE_LENGTH; ++i) {
+            mixed[i] += static_cast<float>(weightedWaveTable.waveTable[i] * weightedWaveTable.weight);
         }
+    }
+    return mixed;
+}
 
-        const auto deviceInfo = Pa_GetDeviceInfo(deviceId);
-        if (deviceInfo) {
-            M_INFO("Opened output device '{}'.", deviceInfo->name);
-        } else {
-            throw MicrotoneException(fmt::format("Unable to collect info on output device {}.", deviceId));
-        }
+std::shared_ptr<const TuningTable> makeTuningTable(const Tuning& tuning, double sampleRate) {
+    auto table = std::make_shared<TuningTable>();
+    for (auto note = 0; note < MIDI_NOTE_COUNT; ++note) {
+        table->frequencies[note] = tuning.frequency(note);
+        table->phaseIncrements[note] = phaseIncrement(tuning.frequency(note), sampleRate);
+    }
+    return table;
+}
 
-        _sampleRate = deviceInfo->defaultSampleRate;
-
-        outputParameters.channelCount = 2;
-        outputParameters.sampleFormat = paFloat32;
-        outputParameters.suggestedLatency = deviceInfo->defaultLowOutputLatency;
-        outputParameters.hostApiSpecificStreamInfo = nullptr;
-
-        PaError openStreamResult = Pa_OpenStream(
-            &_portAudioStream,
-            nullptr,
-            &outputParameters,
-            _sampleRate,
-            FRAMES_PER_BUFFER,
-            paClipOff,
-            &impl::paCallback,
-            this);
-
-        if (openStreamResult != paNoError) {
-            throw MicrotoneException(fmt::format("PortAudio error: {}, '{}'.",
-                                                 openStreamResult,
-                                                 Pa_GetErrorText(openStreamResult)));
-        }
+Patch makePatch(const std::vector<WeightedWaveTable>& weightedWaveTables, double sampleRate) {
+    auto patch = Patch{};
+    patch.waveTable = std::make_shared<const BandLimitedWaveTable>(mixWaveTables(weightedWaveTables));
+    patch.tuning = makeTuningTable(Tuning{}, sampleRate);
+    return patch;
+}
+
+struct ScheduledEvent {
+    std::size_t frame;
+    MidiEvent event;
+};
+
+// One instrument, with its own sound, voices and sustain pedal, played from the channels
+// routed to it.
+struct Part {
+    Part(const std::vector<WeightedWaveTable>& weightedWaveTables, const Patch& initialPatch, double sampleRate) :
+        controlWaveTables{weightedWaveTables},
+        controlPatch{initialPatch},
+        patch{std::make_unique<Patch>(initialPatch)},
+        voiceBank{sampleRate},
+        voiceAllocator{voiceBank},
+        sustainedNotes{},
+        sustainPedalOn{false} {
+    }
 
-        for (auto i = 0; i < 127; ++i) {
-            _voices.emplace_back(noteToFrequencyHertz(i),
-                                 Envelope{0.01, 0.1, .8, 0.01, _sampleRate},
-                                 Oscillator{noteToFrequencyHertz(i), _sampleRate},
-                                 LowFrequencyOscillator{0.25, _sampleRate},
-                                 Filter{});
+    std::vector<WeightedWaveTable> controlWaveTables;       // Guarded by the synthesizer's _controlMutex,
+    Patch controlPatch;                                     // as are the latest published values.
+    Snapshot<Patch> patch;
+    VoiceBank voiceBank;
+    VoiceAllocator voiceAllocator;
+    std::array<bool, MIDI_CHANNEL_COUNT * MIDI_NOTE_COUNT> sustainedNotes;     // By channel, then note.
+    bool sustainPedalOn;
+};
+
+// A run of one part's active voices for a render thread.
+struct RenderTask {
+    VoiceBank* voiceBank;
+    const int* voices;
+    int voiceCount;
+};
+
+}
+
+class Synthesizer::impl {
+public:
+    impl(const std::vector<WeightedWaveTable>& weightedWaveTables,
+         std::unique_ptr<AudioBackend> backend,
+         int renderThreads) :
+        _backend{std::move(backend)},
+        _parts{},
+        _channelParts{},
+        _routedParts{},
+        _scheduledEvents{},
+        _scheduledEventCount{0},
+        _nextScheduledEvent{0},
+        _lastRenderTime{std::chrono::steady_clock::now()},
+        _outputTap{std::make_shared<OutputTap>()},
+        _sampleRate{_backend->sampleRate()},
+        _realtime{_backend->isRealtime()},
+        _renderPool{renderThreads > 1 ? std::make_unique<RenderPool>(renderThreads) : nullptr},
+        _threadBuffers(static_cast<std::size_t>(std::max(renderThreads, 1))),
+        _renderTasks{},
+        _retiredVoices{},
+        _blockPeakVoices{0} {
+        // Every part starts out with the same sound, sharing its tables. Every channel plays
+        // part 0 until it's routed elsewhere.
+        auto patch = makePatch(weightedWaveTables, _sampleRate);
+        for (auto part = 0; part < MAX_PARTS; ++part) {
+            _parts.push_back(std::make_unique<Part>(weightedWaveTables, patch, _sampleRate));
+        }
+        for (auto& channelPart : _channelParts) {
+            channelPart.store(0);
         }
+
+        _backend->open([this](float* out, std::size_t frames) {
+            render(out, frames);
+        });
     }
 
     ~impl() {
-        if (_portAudioStream && _portAudioStream) {
-            Pa_StopStream(_portAudioStream);
-        }
-        Pa_Terminate();
+        // Close the stream before the voices it renders go away.
+        _backend.reset();
     }
 
     void start() {
-        auto startStreamResult = Pa_StartStream(_portAudioStream);
-        if (startStreamResult != paNoError) {
-            throw MicrotoneException(fmt::format("PortAudio error: {}, '{}'.",
-                                                 startStreamResult,
-                                                 Pa_GetErrorText(startStreamResult)));
-        }
+        _backend->start();
         M_INFO("Started synthesizer.");
     }
 
     void stop() {
-        auto stopStreamResult = Pa_StopStream(_portAudioStream);
-        if (stopStreamResult != paNoError) {
-            throw MicrotoneException(fmt::format("PortAudio error: {}, '{}'.",
-                                                 stopStreamResult,
-                                                 Pa_GetErrorText(stopStreamResult)));
-        }
+        _backend->stop();
         M_INFO("Stopped synthesizer.");
     }
 
-    /* This routine will be called by the PortAudio engine when audio is needed.
-       It may called at interrupt level on some machines so don't do anything
-       that could mess up the system like calling malloc() or free().
-    */
-    static int paCallback([[maybe_unused]] const void* inputBuffer,
-                          void* outputBuffer,
-                          unsigned long framesPerBuffer,
-                          [[maybe_unused]] const PaStreamCallbackTimeInfo* timeInfo,
-                          [[maybe_unused]] PaStreamCallbackFlags statusFlags,
-                          void* userData) {
-        auto data = static_cast<impl*>(userData);
-        auto out = static_cast<float*>(outputBuffer);
-
-        for (auto frame = 0; frame < static_cast<int>(framesPerBuffer); ++frame) {
-            auto sample = data->nextSample();
-            data->_lastOutputBuffer[frame] = sample;
-
-            for (std::size_t channel = 0; channel < 2; ++channel) {
-                *out++ = sample;
-            }
+    void render(float* out, std::size_t frames) {
+        if (frames == 0) {
+            return;
+        }
+
+        auto realtimeScope = RealtimeScope{};
+        auto renderTime = std::chrono::steady_clock::now();
+        // Parameter changes take effect on block boundaries, note events on their frame.
+        for (auto& part : _parts) {
+            auto patch = part->patch.acquire();
+            part->voiceBank.setPatch(patch);
+            part->voiceAllocator.setPolyphony(patch->polyphony);
+            part->voiceAllocator.setStealingPolicy(patch->voiceStealingPolicy);
+        }
+        routeChannels();
+        scheduleEvents(frames);
+        _blockPeakVoices = 0;
+
+        auto frame = std::size_t{0};
+        while (frame < frames) {
+            auto blockFrames = std::min(frames - frame, static_cast<std::size_t>(FRAMES_PER_BUFFER));
+            renderBlock(out + frame, frame, blockFrames);
+            frame += blockFrames;
         }
+        _outputTap->write(out, frames);
 
-        data->_onOutputFn(data->_lastOutputBuffer);
+        auto deadline = std::chrono::nanoseconds{static_cast<std::int64_t>(frames * 1e9 / _sampleRate)};
+        _metrics.recordRender(std::chrono::steady_clock::now() - renderTime,
+                              deadline,
+                              static_cast<int>(_scheduledEventCount),
+                              activeVoiceCount(),
+                              _blockPeakVoices);
 
-        return paContinue;
+        _lastRenderTime = renderTime;
     }
 
-    float nextSample() {
-        auto nextSample = 0.0;
-        if (_mutex.try_lock()) {
-            if (_voices.empty()) {
-                return 0;
-            }
-            for (auto& id : _activeVoices) {
-                nextSample += _voices[id].nextSample(_weightedWaveTables);
+    SynthesizerMetrics metrics() const {
+        auto metrics = _metrics.read();
+        auto backendStats = _backend->stats();
+        metrics.underflows = backendStats.underflows;
+        metrics.overflows = backendStats.overflows;
+        metrics.cpuLoad = backendStats.cpuLoad;
+        return metrics;
+    }
+
+    // Renders frames starting at startFrame of the current render() call, splitting the
+    // block wherever a scheduled event falls.
+    void renderBlock(float* out, std::size_t startFrame, std::size_t frames) {
+        std::fill(out, out + frames, 0.0f);
+
+        auto endFrame = startFrame + frames;
+        auto frame = startFrame;
+        while (frame < endFrame) {
+            while (_nextScheduledEvent < _scheduledEventCount && _scheduledEvents[_nextScheduledEvent].frame <= frame) {
+                const auto& event = _scheduledEvents[_nextScheduledEvent].event;
+                processMidi(event.status, event.note, event.velocity);
+                ++_nextScheduledEvent;
             }
 
-            _mutex.unlock();
+            auto segmentEnd = endFrame;
+            if (_nextScheduledEvent < _scheduledEventCount) {
+                segmentEnd = std::min(segmentEnd, _scheduledEvents[_nextScheduledEvent].frame);
+            }
+            renderVoices(out + (frame - startFrame), static_cast<int>(segmentEnd - frame));
+            retireFinishedVoices();
+            frame = segmentEnd;
         }
-        return nextSample;
     }
 
-    std::vector<WeightedWaveTable> weightedWaveTables() const {
-        return _weightedWaveTables;
+    // Splits every part's active voices into tasks for the render pool, so parts share the
+    // threads in one pass rather than taking turns. Each thread mixes into its own buffer,
+    // and the partial mixes are summed here on the audio thread.
+    void renderVoices(float* out, int frames) {
+        auto taskCount = 0;
+        auto voiceCount = 0;
+        for (auto& part : _parts) {
+            auto& voiceBank = part->voiceBank;
+            auto partVoiceCount = voiceBank.activeVoiceCount();
+            if (partVoiceCount == 0) {
+                continue;
+            }
+
+            voiceBank.prepareModulation(frames);
+            const auto* voices = voiceBank.activeVoices();
+            for (auto firstVoice = 0; firstVoice < partVoiceCount; firstVoice += VOICES_PER_TASK) {
+                _renderTasks[taskCount++] = RenderTask{&voiceBank, voices + firstVoice, std::min(VOICES_PER_TASK, partVoiceCount - firstVoice)};
+            }
+            voiceCount += partVoiceCount;
+        }
+        _blockPeakVoices = std::max(_blockPeakVoices, voiceCount);
+
+        if (!_renderPool || taskCount <= 1) {
+            for (auto task = 0; task < taskCount; ++task) {
+                const auto& renderTask = _renderTasks[task];
+                renderTask.voiceBank->render(renderTask.voices, renderTask.voiceCount, out, frames);
+            }
+            return;
+        }
+
+        for (auto& buffer : _threadBuffers) {
+            std::fill(buffer.begin(), buffer.begin() + frames, 0.0f);
+        }
+
+        auto renderTask = [this, frames](int task, int thread) {
+            const auto& renderTask = _renderTasks[task];
+            renderTask.voiceBank->render(renderTask.voices, renderTask.voiceCount, _threadBuffers[thread].data(), frames);
+        };
+        _renderPool->run(taskCount, renderTask);
+
+        for (const auto& buffer : _threadBuffers) {
+            for (auto frame = 0; frame < frames; ++frame) {
+                out[frame] += buffer[frame];
+            }
+        }
     }
 
-    void setWaveTables(const std::vector<WeightedWaveTable>& weightedWaveTables) {
-        auto lockGaurd = std::unique_lock<std::mutex>{_mutex};
-        _weightedWaveTables = weightedWaveTables;
+    // Voices stop costing anything as soon as their release ends, not on the next note.
+    void retireFinishedVoices() {
+        for (auto& part : _parts) {
+            auto retiredCount = part->voiceBank.retireFinishedVoices(_retiredVoices.data());
+            for (auto i = 0; i < retiredCount; ++i) {
+                part->voiceAllocator.retire(_retiredVoices[i]);
+            }
+        }
     }
 
-    void setEnvelope(const Envelope& envelope) {
-        auto lockGaurd = std::unique_lock<std::mutex>{_mutex};
-        for (auto& voice : _voices) {
-            voice.setEnvelope(envelope);
+    int activeVoiceCount() const {
+        auto count = 0;
+        for (const auto& part : _parts) {
+            count += part->voiceBank.activeVoiceCount();
         }
+        return count;
     }
 
-    void setFilter(const Filter& filter) {
-        auto lockGaurd = std::unique_lock<std::mutex>{_mutex};
-        for (auto& voice : _voices) {
-            voice.setFilter(filter);
+    // Audio thread: picks up channels routed to a different part. Notes the old part is
+    // holding on them are released there, since their note offs will go to the new one.
+    void routeChannels() {
+        for (auto channel = 0; channel < MIDI_CHANNEL_COUNT; ++channel) {
+            auto routedPart = _channelParts[channel].load(std::memory_order_relaxed);
+            if (routedPart == _routedParts[channel]) {
+                continue;
+            }
+
+            auto& part = *_parts[_routedParts[channel]];
+            for (auto note = 0; note < MIDI_NOTE_COUNT; ++note) {
+                noteOff(part, channel, note);
+                part.sustainedNotes[channel * MIDI_NOTE_COUNT + note] = false;
+            }
+            _routedParts[channel] = routedPart;
         }
     }
 
-    double noteToFrequencyHertz(int note) {
-        constexpr auto pitch = 440.0f;
-        return pitch * std::pow(2.0f, static_cast<float>(note - 69) / 12.0);
+    // Audio thread: drains the queue and gives every event a frame offset inside this
+    // render() call. Events that arrived during the previous call land at the same relative
+    // position here, trading one buffer of constant latency for sample-accurate timing.
+    // Events given a frame keep it, which is what keeps offline renders repeatable.
+    void scheduleEvents(std::size_t frames) {
+        _scheduledEventCount = 0;
+        _nextScheduledEvent = 0;
+
+        auto event = MidiEvent{};
+        while (_scheduledEventCount < _scheduledEvents.size() && _events.pop(event)) {
+            auto offset = event.frame >= 0 ? event.frame : std::chrono::duration<double>(event.timestamp - _lastRenderTime).count() * _sampleRate;
+            auto frame = static_cast<std::size_t>(std::clamp(offset, 0.0, static_cast<double>(frames - 1)));
+
+            // Producers on different threads may interleave slightly out of order.
+            auto index = _scheduledEventCount++;
+            while (index > 0 && _scheduledEvents[index - 1].frame > frame) {
+                _scheduledEvents[index] = _scheduledEvents[index - 1];
+                --index;
+            }
+            _scheduledEvents[index] = ScheduledEvent{frame, event};
+        }
     }
 
-    void addMidiData(int status, int note, int velocity) {
-        auto lockGaurd = std::unique_lock<std::mutex>{_mutex};
-        auto midiStatus = MidiStatusMessage(status);
+    void processMidi(int status, int note, int velocity) {
+        // System messages have no channel, so no part to play them.
+        if (status < 0x80 || status >= 0xF0) {
+            return;
+        }
+        auto midiStatus = MidiStatusMessage(status & 0xF0);
+        auto channel = status & 0x0F;
+        auto& part = *_parts[_routedParts[channel]];
+        auto& voiceBank = part.voiceBank;
+
+        // Many keyboards send a note on with zero velocity instead of a note off.
+        if (midiStatus == MidiStatusMessage::NoteOn && velocity == 0) {
+            midiStatus = MidiStatusMessage::NoteOff;
+        }
 
         if (midiStatus == MidiStatusMessage::NoteOn) {
-            _voices[note].setVelocity(velocity);
-            _voices[note].triggerOn();
-            _activeVoices.insert(note);
+            if (!voiceBank.isMapped(note)) {
+                return;
+            }
+            // A retriggered note gets a fresh voice; the old one rings out its release.
+            noteOff(part, channel, note);
+            part.sustainedNotes[channel * MIDI_NOTE_COUNT + note] = false;
+            voiceBank.noteOn(part.voiceAllocator.noteOn(channel, note), channel, note, velocity);
         } else if (midiStatus == MidiStatusMessage::NoteOff) {
-            if (_sustainPedalOn) {
-                _sustainedVoices.insert(note);
+            if (part.sustainPedalOn) {
+                part.sustainedNotes[channel * MIDI_NOTE_COUNT + note] = true;
             } else {
-                _voices[note].triggerOff();
+                noteOff(part, channel, note);
             }
+        } else if (midiStatus == MidiStatusMessage::PitchBend) {
+            // 14 bits, least significant first, centred on 8192.
+            voiceBank.setPitchBend(channel, static_cast<float>((velocity << 7 | note) - 8192) / 8192.0f);
+        } else if (midiStatus == MidiStatusMessage::ChannelPressure) {
+            voiceBank.setPressure(channel, static_cast<float>(note) / 127.0f);
         } else if (midiStatus == MidiStatusMessage::ControlChange) {
             if (note == 64) {
-                _sustainPedalOn = velocity > 64;
-                if (!_sustainPedalOn) {
-                    for (const auto& id : _sustainedVoices) {
-                        _voices[id].triggerOff();
+                // The pedal holds every note of the part, whichever channel it's on.
+                part.sustainPedalOn = velocity > 64;
+                if (!part.sustainPedalOn) {
+                    for (auto id = 0; id < static_cast<int>(part.sustainedNotes.size()); ++id) {
+                        if (part.sustainedNotes[id]) {
+                            noteOff(part, id / MIDI_NOTE_COUNT, id % MIDI_NOTE_COUNT);
+                            part.sustainedNotes[id] = false;
+                        }
                     }
-                    _sustainedVoices.clear();
                 }
+            } else if (note == 74) {
+                voiceBank.setTimbre(channel, static_cast<float>(velocity) / 127.0f);
             }
         }
+    }
 
-        for (const auto& id : _activeVoices) {
-            if (!_voices[id].isActive()) {
-                _activeVoices.erase(id);
-            }
+    void noteOff(Part& part, int channel, int note) {
+        auto voice = part.voiceAllocator.noteOff(channel, note);
+        if (voice != -1) {
+            part.voiceBank.noteOff(voice);
+        }
+    }
+
+    // Control threads: the part's control fields are guarded by _controlMutex. The part
+    // itself never goes away.
+    Part& controlPart(int part) const {
+        if (part < 0 || part >= MAX_PARTS) {
+            throw MicrotoneException(fmt::format("There is no part {}.", part));
+        }
+        return *_parts[part];
+    }
+
+    std::vector<WeightedWaveTable> weightedWaveTables(int part) const {
+        auto& targetPart = controlPart(part);
+        auto lockGaurd = std::unique_lock<std::mutex>{_controlMutex};
+        return targetPart.controlWaveTables;
+    }
+
+    // Control threads: the new wave table is baked here, and the patch it replaces is freed
+    // here too once the audio thread has moved past it.
+    void setWaveTables(const std::vector<WeightedWaveTable>& weightedWaveTables, int part) {
+        auto& targetPart = controlPart(part);
+        auto waveTable = std::make_shared<const BandLimitedWaveTable>(mixWaveTables(weightedWaveTables));
+
+        auto lockGaurd = std::unique_lock<std::mutex>{_controlMutex};
+        targetPart.controlWaveTables = weightedWaveTables;
+        targetPart.controlPatch.waveTable = std::move(waveTable);
+        targetPart.patch.publish(std::make_unique<Patch>(targetPart.controlPatch));
+    }
+
+    // Control threads: the table is compiled here, and sounding notes pick it up at the
+    // start of the next block.
+    void setTuning(const Tuning& tuning, int part) {
+        auto& targetPart = controlPart(part);
+        auto tuningTable = makeTuningTable(tuning, _sampleRate);
+
+        auto lockGaurd = std::unique_lock<std::mutex>{_controlMutex};
+        targetPart.controlPatch.tuning = std::move(tuningTable);
+        targetPart.patch.publish(std::make_unique<Patch>(targetPart.controlPatch));
+    }
+
+    void setEnvelope(const Envelope& envelope, int part) {
+        auto& targetPart = controlPart(part);
+        auto lockGaurd = std::unique_lock<std::mutex>{_controlMutex};
+        targetPart.controlPatch.attack = envelope.attack();
+        targetPart.controlPatch.decay = envelope.decay();
+        targetPart.controlPatch.sustain = envelope.sustain();
+        targetPart.controlPatch.release = envelope.release();
+        targetPart.controlPatch.envelopeCurve = envelope.curve();
+        targetPart.patch.publish(std::make_unique<Patch>(targetPart.controlPatch));
+    }
+
+    void setFilter(const Filter& filter, int part) {
+        auto& targetPart = controlPart(part);
+        auto lockGaurd = std::unique_lock<std::mutex>{_controlMutex};
+        targetPart.controlPatch.filterMode = filter.mode();
+        targetPart.controlPatch.filterTopology = filter.topology();
+        targetPart.controlPatch.filterCutoff = filter.cutoff();
+        targetPart.controlPatch.filterResonance = filter.resonance();
+        targetPart.patch.publish(std::make_unique<Patch>(targetPart.controlPatch));
+    }
+
+    void setPolyphony(int polyphony, int part) {
+        auto& targetPart = controlPart(part);
+        auto lockGaurd = std::unique_lock<std::mutex>{_controlMutex};
+        targetPart.controlPatch.polyphony = polyphony;
+        targetPart.patch.publish(std::make_unique<Patch>(targetPart.controlPatch));
+    }
+
+    void setVoiceStealingPolicy(VoiceStealingPolicy policy, int part) {
+        auto& targetPart = controlPart(part);
+        auto lockGaurd = std::unique_lock<std::mutex>{_controlMutex};
+        targetPart.controlPatch.voiceStealingPolicy = policy;
+        targetPart.patch.publish(std::make_unique<Patch>(targetPart.controlPatch));
+    }
+
+    void setLfoFrequency(int lfo, double frequency, int part) {
+        if (lfo < 0 || lfo >= LFO_COUNT) {
+            throw MicrotoneException(fmt::format("There is no LFO {}.", lfo));
+        }
+
+        auto& targetPart = controlPart(part);
+        auto lockGaurd = std::unique_lock<std::mutex>{_controlMutex};
+        targetPart.controlPatch.lfoFrequencies[lfo] = frequency;
+        targetPart.patch.publish(std::make_unique<Patch>(targetPart.controlPatch));
+    }
+
+    void setModulationRoutes(const std::vector<ModulationRoute>& routes, int part) {
+        if (routes.size() > MAX_MODULATION_ROUTES) {
+            throw MicrotoneException(fmt::format("At most {} modulation routes are supported.", MAX_MODULATION_ROUTES));
+        }
+
+        auto& targetPart = controlPart(part);
+        auto lockGaurd = std::unique_lock<std::mutex>{_controlMutex};
+        std::copy(routes.begin(), routes.end(), targetPart.controlPatch.modulationRoutes.begin());
+        targetPart.controlPatch.modulationRouteCount = static_cast<int>(routes.size());
+        targetPart.patch.publish(std::make_unique<Patch>(targetPart.controlPatch));
+    }
+
+    void setControlRate(int frames, int part) {
+        auto& targetPart = controlPart(part);
+        auto lockGaurd = std::unique_lock<std::mutex>{_controlMutex};
+        targetPart.controlPatch.controlRate = frames;
+        targetPart.patch.publish(std::make_unique<Patch>(targetPart.controlPatch));
+    }
+
+    void setPitchBendRange(double semitones, int part) {
+        auto& targetPart = controlPart(part);
+        auto lockGaurd = std::unique_lock<std::mutex>{_controlMutex};
+        targetPart.controlPatch.pitchBendRange = semitones;
+        targetPart.patch.publish(std::make_unique<Patch>(targetPart.controlPatch));
+    }
+
+    void setMpe(bool enabled, double notePitchBendRange, int part) {
+        auto& targetPart = controlPart(part);
+        auto lockGaurd = std::unique_lock<std::mutex>{_controlMutex};
+        targetPart.controlPatch.mpe = enabled;
+        targetPart.controlPatch.mpePitchBendRange = notePitchBendRange;
+        targetPart.patch.publish(std::make_unique<Patch>(targetPart.controlPatch));
+    }
+
+    // Takes effect at the start of the next block.
+    void setChannelPart(int channel, int part) {
+        controlPart(part);
+        if (channel < 0 || channel >= MIDI_CHANNEL_COUNT) {
+            throw MicrotoneException(fmt::format("There is no MIDI channel {}.", channel));
+        }
+        _channelParts[channel].store(part, std::memory_order_relaxed);
+    }
+
+    // Safe to call from any thread: the event is applied in the next block, at the frame
+    // matching its timestamp.
+    void addMidiData(int status, int note, int velocity, int frame, std::chrono::steady_clock::time_point timestamp) {
+        if (!_events.push(MidiEvent{status, note, velocity, frame, timestamp})) {
+            _metrics.countDroppedEvent();
+            M_WARN("Synthesizer event queue is full, dropping MIDI event.");
         }
     }
 
@@ -216,20 +539,40 @@ public:
         return _sampleRate;
     }
 
-    OnOutputFn _onOutputFn;
-    PaStream* _portAudioStream;    // Owned by port audio, cleaned up by Pa_Terminate().
-    std::mutex _mutex;
-    std::vector<WeightedWaveTable> _weightedWaveTables;
-    AudioBuffer _lastOutputBuffer;  // Forwarded to onOutputFn()
-    std::unordered_set<int> _activeVoices;
-    std::unordered_set<int> _sustainedVoices;
-    std::vector<SynthesizerVoice> _voices;
-    bool _sustainPedalOn;
+    std::unique_ptr<AudioBackend> _backend;
+    mutable std::mutex _controlMutex;                       // Serializes control threads only, never taken by the audio thread.
+    std::vector<std::unique_ptr<Part>> _parts;              // MAX_PARTS of them, for the synthesizer's lifetime.
+    std::array<std::atomic<int>, MIDI_CHANNEL_COUNT> _channelParts;       // Set by control threads.
+    std::array<int, MIDI_CHANNEL_COUNT> _routedParts;                     // What the audio thread is playing them on.
+    EventQueue<MidiEvent, EVENT_QUEUE_CAPACITY> _events;
+    std::array<ScheduledEvent, EVENT_QUEUE_CAPACITY> _scheduledEvents;
+    std::size_t _scheduledEventCount;
+    std::size_t _nextScheduledEvent;
+    std::chrono::steady_clock::time_point _lastRenderTime;
+    std::shared_ptr<OutputTap> _outputTap;                  // Shared with readers, which may outlive the synthesizer.
     double _sampleRate;
+    bool _realtime;                                         // False when the host renders offline.
+    std::unique_ptr<RenderPool> _renderPool;                // Null when rendering on the audio thread alone.
+    std::vector<AudioBuffer> _threadBuffers;                // One partial mix per render thread.
+    std::array<RenderTask, MAX_RENDER_TASKS> _renderTasks;
+    std::array<int, MAX_VOICES> _retiredVoices;
+    int _blockPeakVoices;                                   // Most voices sounding at once in the current render() call.
+    MetricsRecorder _metrics;
 };
 
-Synthesizer::Synthesizer(const std::vector<WeightedWaveTable>& weightedWaveTables, OnOutputFn fn) :
-    _impl{new impl{weightedWaveTables, fn}} {
+Synthesizer::Synthesizer(const std::vector<WeightedWaveTable>& weightedWaveTables) :
+    _impl{new impl{weightedWaveTables, std::make_unique<PortAudioBackend>(), 1}} {
+}
+
+Synthesizer::Synthesizer(const std::vector<WeightedWaveTable>& weightedWaveTables,
+                         std::unique_ptr<AudioBackend> backend) :
+    _impl{new impl{weightedWaveTables, std::move(backend), 1}} {
+}
+
+Synthesizer::Synthesizer(const std::vector<WeightedWaveTable>& weightedWaveTables,
+                         std::unique_ptr<AudioBackend> backend,
+                         int renderThreads) :
+    _impl{new impl{weightedWaveTables, std::move(backend), renderThreads}} {
 }
 
 Synthesizer::Synthesizer(Synthesizer&& other) noexcept :
@@ -253,24 +596,84 @@ void Synthesizer::stop() {
     _impl->stop();
 }
 
-std::vector<WeightedWaveTable> Synthesizer::weightedWaveTables() const {
-    return _impl->weightedWaveTables();
+std::vector<WeightedWaveTable> Synthesizer::weightedWaveTables(int part) const {
+    return _impl->weightedWaveTables(part);
 }
 
-void Synthesizer::setWaveTables(const std::vector<WeightedWaveTable>& weightedWaveTables) {
-    _impl->setWaveTables(weightedWaveTables);
+void Synthesizer::setWaveTables(const std::vector<WeightedWaveTable>& weightedWaveTables, int part) {
+    _impl->setWaveTables(weightedWaveTables, part);
 }
 
-void Synthesizer::setEnvelope(const Envelope& envelope) {
-    _impl->setEnvelope(envelope);
+void Synthesizer::setTuning(const Tuning& tuning, int part) {
+    _impl->setTuning(tuning, part);
 }
 
-void Synthesizer::setFilter(const Filter& filter) {
-    _impl->setFilter(filter);
+void Synthesizer::setEnvelope(const Envelope& envelope, int part) {
+    _impl->setEnvelope(envelope, part);
+}
+
+void Synthesizer::setFilter(const Filter& filter, int part) {
+    _impl->setFilter(filter, part);
+}
+
+void Synthesizer::setPolyphony(int polyphony, int part) {
+    _impl->setPolyphony(polyphony, part);
+}
+
+void Synthesizer::setVoiceStealingPolicy(VoiceStealingPolicy policy, int part) {
+    _impl->setVoiceStealingPolicy(policy, part);
+}
+
+void Synthesizer::setLfoFrequency(int lfo, double frequency, int part) {
+    _impl->setLfoFrequency(lfo, frequency, part);
+}
+
+void Synthesizer::setModulationRoutes(const std::vector<ModulationRoute>& routes, int part) {
+    _impl->setModulationRoutes(routes, part);
+}
+
+void Synthesizer::setControlRate(int frames, int part) {
+    _impl->setControlRate(frames, part);
+}
+
+void Synthesizer::setPitchBendRange(double semitones, int part) {
+    _impl->setPitchBendRange(semitones, part);
+}
+
+void Synthesizer::setMpe(bool enabled, double notePitchBendRange, int part) {
+    _impl->setMpe(enabled, notePitchBendRange, part);
+}
+
+void Synthesizer::setChannelPart(int channel, int part) {
+    _impl->setChannelPart(channel, part);
+}
+
+void Synthesizer::render(float* out, std::size_t frames) {
+    _impl->render(out, frames);
+}
+
+OutputTapReader Synthesizer::outputTap() const {
+    return OutputTapReader{_impl->_outputTap};
+}
+
+SynthesizerMetrics Synthesizer::metrics() const {
+    return _impl->metrics();
 }
 
 void Synthesizer::addMidiData(int status, int note, int velocity) {
-    _impl->addMidiData(status, note, velocity);
+    if (_impl->_realtime) {
+        _impl->addMidiData(status, note, velocity, -1, std::chrono::steady_clock::now());
+    } else {
+        _impl->addMidiData(status, note, velocity, 0, {});
+    }
+}
+
+void Synthesizer::addMidiData(int status, int note, int velocity, std::chrono::steady_clock::time_point timestamp) {
+    _impl->addMidiData(status, note, velocity, -1, timestamp);
+}
+
+void Synthesizer::addMidiData(int status, int note, int velocity, int frame) {
+    _impl->addMidiData(status, note, velocity, std::max(frame, 0), {});
 }
 
 double Synthesizer::sampleRate() {
@@ -1,8 +1,10 @@
 #include <microtone/exception.hpp>
 #include <microtone/log.hpp>
+#include <microtone/synthesizer/audio_buffer.hpp>
 #include <microtone/synthesizer/envelope.hpp>
 #include <microtone/synthesizer/synthesizer_voice.hpp>
 
+#include <algorithm>
 #include <cmath>
 
 namespace microtone {
@@ -53,9 +55,26 @@ public:
         _envelope.triggerOff();
     }
 
-    float nextSample(const std::vector<WeightedWaveTable>& weightedWaveTables) {
-        auto nextSample = _oscillator.nextSample(weightedWaveTables);
-        return _filter.nextSample(_envelope.nextSample() * static_cast<float>(_velocity) * nextSample);
+    void processBlock(const std::vector<WeightedWaveTable>& weightedWaveTables, float* out, int frames) {
+        const auto velocity = static_cast<float>(_velocity);
+        // Scratch space on the stack, deliberately left uninitialized.
+        AudioBuffer oscillatorBuffer;
+        AudioBuffer envelopeBuffer;
+        while (frames > 0) {
+            auto blockFrames = std::min(frames, FRAMES_PER_BUFFER);
+            _oscillator.processBlock(weightedWaveTables, oscillatorBuffer.data(), blockFrames);
+            _envelope.processBlock(envelopeBuffer.data(), blockFrames);
+            for (auto frame = 0; frame < blockFrames; ++frame) {
+                oscillatorBuffer[frame] *= envelopeBuffer[frame] * velocity;
+            }
+            _filter.processBlock(oscillatorBuffer.data(), blockFrames);
+            for (auto frame = 0; frame < blockFrames; ++frame) {
+                out[frame] += oscillatorBuffer[frame];
+            }
+
+            out += blockFrames;
+            frames -= blockFrames;
+        }
     }
 
     double _frequency;
@@ -116,7 +135,13 @@ void SynthesizerVoice::triggerOff() {
 }
 
 float SynthesizerVoice::nextSample(const std::vector<WeightedWaveTable>& weightedWaveTables) {
-    return _impl->nextSample(weightedWaveTables);
+    auto sample = 0.0f;
+    _impl->processBlock(weightedWaveTables, &sample, 1);
+    return sample;
+}
+
+void SynthesizerVoice::processBlock(const std::vector<WeightedWaveTable>& weightedWaveTables, float* out, int frames) {
+    _impl->processBlock(weightedWaveTables, out, frames);
 }
 
 }
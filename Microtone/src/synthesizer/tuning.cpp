@@ -0,0 +1,283 @@
+#include <microtone/exception.hpp>
+#include <microtone/log.hpp>
+#include <microtone/synthesizer/tuning.hpp>
+
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace microtone {
+
+namespace {
+
+// Which scale degree each key plays, as read from a .kbm file. Degrees repeat every size
+// keys either side of middle, each repeat moving up by the scale's octaveDegree.
+struct KeyboardMapping {
+    int size;                               // 0 maps every key to the next degree.
+    int firstNote;
+    int lastNote;
+    int middleNote;                         // Plays degree 0.
+    int referenceNote;
+    double referenceFrequency;
+    int octaveDegree;                       // 0 repeats at the scale's period.
+    std::vector<int> degrees;               // -1 for unmapped keys.
+};
+
+// What Scala assumes without a .kbm file.
+KeyboardMapping linearMapping() {
+    return KeyboardMapping{0, 0, MIDI_NOTE_COUNT - 1, 60, 69, 440.0, 0, {}};
+}
+
+int floorDivide(int dividend, int divisor) {
+    return dividend / divisor - (dividend % divisor < 0 ? 1 : 0);
+}
+
+// Scala files are lines of text where a leading '!' marks a comment.
+std::vector<std::string> scalaLines(const std::string& text) {
+    auto lines = std::vector<std::string>{};
+    auto stream = std::istringstream{text};
+    auto line = std::string{};
+    while (std::getline(stream, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] != '!') {
+            lines.push_back(line);
+        }
+    }
+    return lines;
+}
+
+// The first whitespace separated word of line; anything after it is a comment.
+std::string firstWord(const std::string& line) {
+    auto word = std::string{};
+    std::istringstream{line} >> word;
+    return word;
+}
+
+// A pitch line holds cents when it has a decimal point, otherwise a ratio or a whole number.
+double parsePitch(const std::string& line) {
+    auto word = firstWord(line);
+    try {
+        auto parsed = std::size_t{0};
+        auto ratio = 0.0;
+        if (word.find('.') != std::string::npos) {
+            ratio = std::exp2(std::stod(word, &parsed) / 1200.0);
+        } else {
+            auto slash = word.find('/');
+            ratio = static_cast<double>(std::stoll(word, &parsed));
+            if (slash != std::string::npos && parsed == slash) {
+                auto denominatorParsed = std::size_t{0};
+                ratio /= static_cast<double>(std::stoll(word.substr(slash + 1), &denominatorParsed));
+                parsed = slash + 1 + denominatorParsed;
+            }
+        }
+        if (parsed == word.size() && std::isfinite(ratio) && ratio > 0) {
+            return ratio;
+        }
+    } catch (const std::logic_error&) {
+    }
+    throw MicrotoneException(fmt::format("Invalid pitch '{}' in scale file.", line));
+}
+
+// Returns the scale's ratios, degree 1 to the period, and sets description.
+std::vector<double> parseScale(const std::string& scl, std::string& description) {
+    auto lines = scalaLines(scl);
+    // The description may be blank; nothing after it may.
+    auto line = lines.begin();
+    if (line == lines.end()) {
+        throw MicrotoneException("Scale file is empty.");
+    }
+    description = *line++;
+
+    auto next = [&]() {
+        while (line != lines.end() && firstWord(*line).empty()) {
+            ++line;
+        }
+        if (line == lines.end()) {
+            throw MicrotoneException("Scale file ends early.");
+        }
+        return *line++;
+    };
+
+    auto count = 0;
+    try {
+        count = std::stoi(firstWord(next()));
+    } catch (const std::logic_error&) {
+        throw MicrotoneException("Invalid note count in scale file.");
+    }
+    if (count < 1) {
+        throw MicrotoneException("A scale needs at least one note.");
+    }
+
+    auto scale = std::vector<double>{};
+    for (auto i = 0; i < count; ++i) {
+        scale.push_back(parsePitch(next()));
+    }
+    return scale;
+}
+
+KeyboardMapping parseKeyboardMapping(const std::string& kbm) {
+    auto words = std::vector<std::string>{};
+    for (const auto& line : scalaLines(kbm)) {
+        auto word = firstWord(line);
+        if (!word.empty()) {
+            words.push_back(word);
+        }
+    }
+    if (words.size() < 7) {
+        throw MicrotoneException("Keyboard mapping file ends early.");
+    }
+
+    auto mapping = KeyboardMapping{};
+    try {
+        mapping.size = std::stoi(words[0]);
+        mapping.firstNote = std::stoi(words[1]);
+        mapping.lastNote = std::stoi(words[2]);
+        mapping.middleNote = std::stoi(words[3]);
+        mapping.referenceNote = std::stoi(words[4]);
+        mapping.referenceFrequency = std::stod(words[5]);
+        mapping.octaveDegree = std::stoi(words[6]);
+        // Keys past the end of a short list are unmapped.
+        for (auto key = 0; key < mapping.size; ++key) {
+            auto index = static_cast<std::size_t>(7 + key);
+            mapping.degrees.push_back(index < words.size() && words[index] != "x" ? std::stoi(words[index]) : -1);
+        }
+    } catch (const std::logic_error&) {
+        throw MicrotoneException("Invalid value in keyboard mapping file.");
+    }
+    if (mapping.size < 0 || !(mapping.referenceFrequency > 0)) {
+        throw MicrotoneException("Invalid keyboard mapping.");
+    }
+    return mapping;
+}
+
+// The ratio of any degree of the scale, repeating it every period.
+double degreeRatio(const std::vector<double>& scale, int degree) {
+    auto size = static_cast<int>(scale.size());
+    auto periods = floorDivide(degree, size);
+    auto step = degree - periods * size;
+    return std::pow(scale.back(), periods) * (step == 0 ? 1.0 : scale[static_cast<std::size_t>(step - 1)]);
+}
+
+// Relative to the middle note, or 0 when the key is unmapped.
+double noteRatio(const std::vector<double>& scale, const KeyboardMapping& mapping, int note) {
+    if (note < mapping.firstNote || note > mapping.lastNote) {
+        return 0;
+    }
+
+    auto offset = note - mapping.middleNote;
+    if (mapping.size == 0) {
+        return degreeRatio(scale, offset);
+    }
+    auto repeats = floorDivide(offset, mapping.size);
+    auto degree = mapping.degrees[static_cast<std::size_t>(offset - repeats * mapping.size)];
+    if (degree < 0) {
+        return 0;
+    }
+    auto octaveRatio = mapping.octaveDegree == 0 ? scale.back() : degreeRatio(scale, mapping.octaveDegree);
+    return degreeRatio(scale, degree) * std::pow(octaveRatio, repeats);
+}
+
+std::string readFile(const std::string& path) {
+    auto file = std::ifstream{path};
+    if (!file) {
+        throw MicrotoneException(fmt::format("Unable to read tuning file {}.", path));
+    }
+    auto contents = std::stringstream{};
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+}
+
+class Tuning::impl {
+public:
+    impl(const std::string& description, const std::vector<double>& scale, const KeyboardMapping& mapping) :
+        _description{description},
+        _frequencies{} {
+        // The reference note counts as in range, so the reference frequency still anchors the
+        // scale when it lies outside the mapped keys.
+        auto referenceMapping = mapping;
+        referenceMapping.firstNote = mapping.referenceNote;
+        referenceMapping.lastNote = mapping.referenceNote;
+        auto referenceRatio = noteRatio(scale, referenceMapping, mapping.referenceNote);
+        if (referenceRatio == 0) {
+            throw MicrotoneException(fmt::format("The keyboard mapping leaves reference note {} unmapped.", mapping.referenceNote));
+        }
+
+        for (auto note = 0; note < MIDI_NOTE_COUNT; ++note) {
+            _frequencies[static_cast<std::size_t>(note)] = mapping.referenceFrequency * noteRatio(scale, mapping, note) / referenceRatio;
+        }
+    }
+
+    std::string _description;
+    std::array<double, MIDI_NOTE_COUNT> _frequencies;
+};
+
+Tuning::Tuning() :
+    Tuning{equalTemperament(12)} {
+}
+
+Tuning::Tuning(std::unique_ptr<impl> impl) :
+    _impl{std::move(impl)} {
+}
+
+Tuning::Tuning(const Tuning& other) :
+    _impl{new impl{*other._impl}} {
+}
+
+Tuning::Tuning(Tuning&& other) noexcept :
+    _impl{std::move(other._impl)} {
+}
+
+Tuning& Tuning::operator=(const Tuning& other) {
+    _impl = std::make_unique<impl>(*other._impl);
+    return *this;
+}
+
+Tuning& Tuning::operator=(Tuning&& other) noexcept {
+    if (this != &other) {
+        _impl = std::move(other._impl);
+    }
+    return *this;
+}
+
+Tuning::~Tuning() = default;
+
+Tuning Tuning::equalTemperament(int divisions) {
+    if (divisions < 1) {
+        throw MicrotoneException(fmt::format("Can't divide the octave into {} steps.", divisions));
+    }
+
+    auto scale = std::vector<double>{};
+    for (auto step = 1; step <= divisions; ++step) {
+        scale.push_back(std::exp2(static_cast<double>(step) / divisions));
+    }
+    return Tuning{std::make_unique<impl>(fmt::format("{} equal divisions of the octave", divisions), scale, linearMapping())};
+}
+
+Tuning Tuning::fromScala(const std::string& scl, const std::string& kbm) {
+    auto description = std::string{};
+    auto scale = parseScale(scl, description);
+    return Tuning{std::make_unique<impl>(description, scale, kbm.empty() ? linearMapping() : parseKeyboardMapping(kbm))};
+}
+
+Tuning Tuning::fromScalaFiles(const std::string& sclPath, const std::string& kbmPath) {
+    return fromScala(readFile(sclPath), kbmPath.empty() ? std::string{} : readFile(kbmPath));
+}
+
+std::string Tuning::description() const {
+    return _impl->_description;
+}
+
+double Tuning::frequency(int note) const {
+    if (note < 0 || note >= MIDI_NOTE_COUNT) {
+        return 0;
+    }
+    return _impl->_frequencies[static_cast<std::size_t>(note)];
+}
+
+}
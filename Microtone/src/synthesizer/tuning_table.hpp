@@ -0,0 +1,17 @@
+#pragma once
+
+#include <microtone/midi_input.hpp>
+#include <microtone/synthesizer/oscillator_kernel.hpp>
+
+#include <array>
+
+namespace microtone {
+
+// A Tuning compiled for one sample rate on a control thread, so the audio thread looks
+// notes up rather than calling pow. Unmapped notes have a frequency of 0.
+struct TuningTable {
+    std::array<double, MIDI_NOTE_COUNT> frequencies;
+    std::array<OscillatorPhase, MIDI_NOTE_COUNT> phaseIncrements;
+};
+
+}
@@ -0,0 +1,132 @@
+#include <synthesizer/voice_allocator.hpp>
+
+#include <algorithm>
+
+namespace microtone {
+
+VoiceAllocator::VoiceList::VoiceList() :
+    head{-1},
+    tail{-1},
+    previous{},
+    next{} {
+}
+
+void VoiceAllocator::VoiceList::pushBack(int voice) {
+    previous[voice] = tail;
+    next[voice] = -1;
+    if (tail != -1) {
+        next[tail] = voice;
+    } else {
+        head = voice;
+    }
+    tail = voice;
+}
+
+void VoiceAllocator::VoiceList::remove(int voice) {
+    if (previous[voice] != -1) {
+        next[previous[voice]] = next[voice];
+    } else {
+        head = next[voice];
+    }
+    if (next[voice] != -1) {
+        previous[next[voice]] = previous[voice];
+    } else {
+        tail = previous[voice];
+    }
+}
+
+VoiceAllocator::VoiceAllocator(const VoiceBank& voiceBank) :
+    _voiceBank{voiceBank},
+    _polyphony{DEFAULT_POLYPHONY},
+    _stealingPolicy{VoiceStealingPolicy::ReleasedFirst},
+    _freeCount{MAX_VOICES},
+    _freeVoices{},
+    _voiceNotes{},
+    _released{},
+    _noteVoices{} {
+    // Hand out low voices first.
+    for (auto i = 0; i < MAX_VOICES; ++i) {
+        _freeVoices[i] = MAX_VOICES - 1 - i;
+    }
+    _voiceNotes.fill(-1);
+    _noteVoices.fill(-1);
+}
+
+void VoiceAllocator::setPolyphony(int polyphony) {
+    _polyphony = std::clamp(polyphony, 1, MAX_VOICES);
+}
+
+void VoiceAllocator::setStealingPolicy(VoiceStealingPolicy policy) {
+    _stealingPolicy = policy;
+}
+
+int VoiceAllocator::noteOn(int channel, int note) {
+    auto voice = -1;
+    if (MAX_VOICES - _freeCount < _polyphony) {
+        voice = _freeVoices[--_freeCount];
+    } else {
+        voice = stealVoice();
+        if (!_released[voice]) {
+            _noteVoices[_voiceNotes[voice]] = -1;
+        } else {
+            _byRelease.remove(voice);
+        }
+        _byAge.remove(voice);
+    }
+
+    _byAge.pushBack(voice);
+    _released[voice] = false;
+    _voiceNotes[voice] = channel * MIDI_NOTE_COUNT + note;
+    _noteVoices[_voiceNotes[voice]] = voice;
+    return voice;
+}
+
+int VoiceAllocator::noteOff(int channel, int note) {
+    auto voice = _noteVoices[channel * MIDI_NOTE_COUNT + note];
+    if (voice != -1) {
+        release(voice);
+    }
+    return voice;
+}
+
+int VoiceAllocator::stealVoice() {
+    if (_stealingPolicy == VoiceStealingPolicy::ReleasedFirst && _byRelease.head != -1) {
+        return _byRelease.head;
+    }
+
+    if (_stealingPolicy == VoiceStealingPolicy::Quietest) {
+        auto quietestVoice = _byAge.head;
+        auto quietestLevel = _voiceBank.level(quietestVoice);
+        for (auto voice = _byAge.next[quietestVoice]; voice != -1; voice = _byAge.next[voice]) {
+            auto level = _voiceBank.level(voice);
+            if (level < quietestLevel) {
+                quietestVoice = voice;
+                quietestLevel = level;
+            }
+        }
+        return quietestVoice;
+    }
+
+    return _byAge.head;
+}
+
+void VoiceAllocator::release(int voice) {
+    _noteVoices[_voiceNotes[voice]] = -1;
+    _voiceNotes[voice] = -1;
+    _released[voice] = true;
+    _byRelease.pushBack(voice);
+}
+
+void VoiceAllocator::retire(int voice) {
+    if (_released[voice]) {
+        _byRelease.remove(voice);
+    } else {
+        _noteVoices[_voiceNotes[voice]] = -1;
+    }
+    _byAge.remove(voice);
+    _released[voice] = false;
+    _voiceNotes[voice] = -1;
+    _freeVoices[_freeCount++] = voice;
+}
+
+}
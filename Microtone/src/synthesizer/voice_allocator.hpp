@@ -0,0 +1,61 @@
+#pragma once
+
+#include <microtone/midi_input.hpp>
+#include <microtone/synthesizer/polyphony.hpp>
+
+#include <synthesizer/voice_bank.hpp>
+
+#include <array>
+
+namespace microtone {
+
+// Maps notes to voices of the voice bank. A note is held per channel, so with MPE the same
+// pitch can sound on two channels at once. Voices come from a free list, so a note on
+// takes constant time unless it has to steal. Oldest and released-first steals are
+// constant time too; quietest scans the sounding voices. Nothing here allocates.
+class VoiceAllocator {
+public:
+    explicit VoiceAllocator(const VoiceBank& voiceBank);
+
+    // Takes effect on the next note on. Voices over a lowered limit play out until they
+    // finish or get stolen.
+    void setPolyphony(int polyphony);
+    void setStealingPolicy(VoiceStealingPolicy policy);
+
+    // Returns the voice to start for note.
+    int noteOn(int channel, int note);
+    // Returns the voice holding note, or -1 when it isn't held.
+    int noteOff(int channel, int note);
+
+    // Returns a voice the voice bank has finished with to the free list.
+    void retire(int voice);
+
+private:
+    // Intrusive doubly linked list over voice indices.
+    struct VoiceList {
+        VoiceList();
+        void pushBack(int voice);
+        void remove(int voice);
+
+        int head;
+        int tail;
+        std::array<int, MAX_VOICES> previous;
+        std::array<int, MAX_VOICES> next;
+    };
+
+    int stealVoice();
+    void release(int voice);
+
+    const VoiceBank& _voiceBank;
+    int _polyphony;
+    VoiceStealingPolicy _stealingPolicy;
+    int _freeCount;
+    std::array<int, MAX_VOICES> _freeVoices;
+    std::array<int, MAX_VOICES> _voiceNotes;        // Channel * MIDI_NOTE_COUNT + note, -1 once released.
+    std::array<bool, MAX_VOICES> _released;
+    std::array<int, MIDI_CHANNEL_COUNT * MIDI_NOTE_COUNT> _noteVoices;     // -1 when the note isn't held.
+    VoiceList _byAge;                               // Every allocated voice, oldest note on first.
+    VoiceList _byRelease;                           // Released voices, oldest note off first.
+};
+
+}
@@ -0,0 +1,395 @@
+#include <microtone/synthesizer/audio_buffer.hpp>
+#include <microtone/synthesizer/oscillator_kernel.hpp>
+
+#include <synthesizer/pitch_bend.hpp>
+#include <synthesizer/voice_bank.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace microtone {
+
+namespace {
+
+// Cutoff changes glide with this time constant, so neither modulation nor a new patch
+// zips.
+const double FILTER_GLIDE_TIME = 0.005;
+// Close enough to the target, in octaves, to stop gliding and stop recomputing.
+const float FILTER_CUTOFF_SNAP = 0.001f;
+
+}
+
+VoiceBank::VoiceBank(double sampleRate) :
+    _sampleRate{sampleRate},
+    _patch{nullptr},
+    _tuning{nullptr},
+    _oscillatorKernel{oscillatorKernel(bestOscillatorKernel())},
+    _lfos{},
+    _envelopeShape{},
+    _controlRate{DEFAULT_CONTROL_RATE},
+    _lfoValues{},
+    _channelBends{},
+    _channelPressures{},
+    _channelTimbres{},
+    _filterMode{FilterMode::LowPass},
+    _filterTopology{FilterTopology::StateVariable},
+    // Matches no patch, so the first one sets up the filter.
+    _filterResonance{std::numeric_limits<double>::quiet_NaN()},
+    _baseFilterCutoff{0},
+    _baseFilterCoefficients{},
+    _filterKernel{filterBankKernel(FilterTopology::StateVariable)},
+    _filterCutoffSmoothing{1},
+    _activeVoiceCount{0},
+    _activeVoices{},
+    _activeVoicePositions{},
+    _notes{},
+    _channels{},
+    _phases{},
+    _phaseIncrements{},
+    _gains{},
+    _envelopes{},
+    _filterStates{},
+    _filterCutoffs{},
+    _filterCoefficientCutoffs{},
+    _filterCoefficients{},
+    _amplitudeModulations{} {
+    _envelopes.fill(EnvelopeGenerator{EnvelopeState::Off, 0.0f, EnvelopeSegment{1.0f, 0.0f, 0.0f, 0}});
+    _lfos.fill(LowFrequencyOscillator{0, sampleRate});
+    // Where MPE controllers rest CC74.
+    _channelTimbres.fill(0.5f);
+    _activeVoicePositions.fill(-1);
+    _filterCoefficientCutoffs.fill(std::numeric_limits<float>::quiet_NaN());
+}
+
+void VoiceBank::setPatch(const Patch* patch) {
+    _patch = patch;
+    _envelopeShape = EnvelopeShape{patch->attack, patch->decay, patch->sustain, patch->release, patch->envelopeCurve};
+    if (patch->tuning.get() != _tuning) {
+        _tuning = patch->tuning.get();
+        retune();
+    }
+
+    auto cutoff = static_cast<float>(std::log2(std::clamp(patch->filterCutoff, MIN_FILTER_CUTOFF, MAX_FILTER_CUTOFF_RATIO * _sampleRate)));
+    auto reshaped = patch->filterMode != _filterMode || patch->filterTopology != _filterTopology || patch->filterResonance != _filterResonance;
+    if (!reshaped && cutoff == _baseFilterCutoff) {
+        return;
+    }
+
+    _filterMode = patch->filterMode;
+    _filterTopology = patch->filterTopology;
+    _filterResonance = patch->filterResonance;
+    _baseFilterCutoff = cutoff;
+    _baseFilterCoefficients = filterCoefficients(_filterMode, _filterTopology, patch->filterCutoff, _filterResonance, _sampleRate);
+    _filterKernel = filterBankKernel(_filterTopology);
+    // A new cutoff alone glides there, recomputing as it goes; anything else invalidates
+    // every voice's coefficients.
+    if (reshaped) {
+        _filterCoefficientCutoffs.fill(std::numeric_limits<float>::quiet_NaN());
+    }
+}
+
+// Sounding notes move to the new tuning with their phase intact. A note the new tuning
+// leaves unmapped keeps its old pitch until it's released.
+void VoiceBank::retune() {
+    for (auto position = 0; position < _activeVoiceCount; ++position) {
+        auto voice = _activeVoices[position];
+        auto note = _notes[voice];
+        if (_tuning->frequencies[note] > 0) {
+            _phaseIncrements[voice] = _tuning->phaseIncrements[note];
+        }
+    }
+}
+
+void VoiceBank::noteOn(int voice, int channel, int note, int velocity) {
+    auto r = std::pow(10, 60 / 20);
+    auto b = 127 / (126 * sqrt(r)) - 1 / 126;
+    auto m = (1 - b) / 127;
+    _gains[voice] = static_cast<float>(std::pow(m * velocity + b, 2));
+
+    _notes[voice] = note;
+    _channels[voice] = channel;
+    _phaseIncrements[voice] = _tuning->phaseIncrements[note];
+    if (_activeVoicePositions[voice] == -1) {
+        _activeVoicePositions[voice] = _activeVoiceCount;
+        _activeVoices[_activeVoiceCount++] = voice;
+    }
+
+    _amplitudeModulations[voice] = 1.0f;
+    _filterCutoffs[voice] = _baseFilterCutoff;
+    triggerEnvelopeOn(_envelopes[voice], _envelopeShape, _sampleRate);
+}
+
+void VoiceBank::noteOff(int voice) {
+    triggerEnvelopeOff(_envelopes[voice], _envelopeShape, _sampleRate);
+}
+
+bool VoiceBank::isMapped(int note) const {
+    return _tuning->frequencies[note] > 0;
+}
+
+bool VoiceBank::isActive(int voice) const {
+    return _envelopes[voice].state != EnvelopeState::Off;
+}
+
+float VoiceBank::level(int voice) const {
+    return _envelopes[voice].level * _gains[voice];
+}
+
+void VoiceBank::setPitchBend(int channel, float bend) {
+    _channelBends[channel] = bend;
+}
+
+void VoiceBank::setPressure(int channel, float pressure) {
+    _channelPressures[channel] = pressure;
+}
+
+void VoiceBank::setTimbre(int channel, float timbre) {
+    _channelTimbres[channel] = timbre;
+}
+
+// With MPE, the master channel's bend moves every note on top of the note's own.
+float VoiceBank::bendCents(int voice) const {
+    auto channel = _channels[voice];
+    if (!_patch->mpe) {
+        return static_cast<float>(_channelBends[channel] * _patch->pitchBendRange * 100);
+    }
+
+    auto semitones = _channelBends[MPE_MASTER_CHANNEL] * _patch->pitchBendRange;
+    if (channel != MPE_MASTER_CHANNEL) {
+        semitones += _channelBends[channel] * _patch->mpePitchBendRange;
+    }
+    return static_cast<float>(semitones * 100);
+}
+
+const int* VoiceBank::activeVoices() const {
+    return _activeVoices.data();
+}
+
+int VoiceBank::activeVoiceCount() const {
+    return _activeVoiceCount;
+}
+
+int VoiceBank::retireFinishedVoices(int* retired) {
+    auto retiredCount = 0;
+    auto position = 0;
+    while (position < _activeVoiceCount) {
+        auto voice = _activeVoices[position];
+        if (_envelopes[voice].state != EnvelopeState::Off) {
+            ++position;
+            continue;
+        }
+
+        // Swap the last voice into the gap.
+        auto lastVoice = _activeVoices[--_activeVoiceCount];
+        _activeVoices[position] = lastVoice;
+        _activeVoicePositions[lastVoice] = position;
+        _activeVoicePositions[voice] = -1;
+        retired[retiredCount++] = voice;
+    }
+    return retiredCount;
+}
+
+void VoiceBank::render(float* out, int frames) {
+    std::array<int, MAX_VOICES> retired;
+    while (frames > 0) {
+        auto blockFrames = std::min(frames, FRAMES_PER_BUFFER);
+        prepareModulation(blockFrames);
+        render(_activeVoices.data(), _activeVoiceCount, out, blockFrames);
+        retireFinishedVoices(retired.data());
+        out += blockFrames;
+        frames -= blockFrames;
+    }
+}
+
+void VoiceBank::prepareModulation(int frames) {
+    _controlRate = std::clamp(_patch->controlRate, 1, FRAMES_PER_BUFFER);
+    _filterCutoffSmoothing = static_cast<float>(1.0 - std::exp(-_controlRate / (FILTER_GLIDE_TIME * _sampleRate)));
+    for (auto lfo = 0; lfo < LFO_COUNT; ++lfo) {
+        _lfos[lfo].setFrequency(_patch->lfoFrequencies[lfo]);
+        // Sampled at the end of each period; voices ramp towards it over the period.
+        auto tick = 0;
+        for (auto start = 0; start < frames; start += _controlRate) {
+            _lfos[lfo].advance(std::min(_controlRate, frames - start));
+            _lfoValues[lfo][tick++] = _lfos[lfo].value();
+        }
+    }
+}
+
+void VoiceBank::render(const int* voices, int voiceCount, float* out, int frames) {
+    std::array<int, FILTER_LANES> group;
+    auto groupSize = 0;
+    for (auto i = 0; i < voiceCount; ++i) {
+        if (_envelopes[voices[i]].state == EnvelopeState::Off) {
+            continue;
+        }
+
+        group[groupSize++] = voices[i];
+        if (groupSize == FILTER_LANES) {
+            renderGroup(group.data(), groupSize, out, frames);
+            groupSize = 0;
+        }
+    }
+    if (groupSize > 0) {
+        renderGroup(group.data(), groupSize, out, frames);
+    }
+}
+
+// Renders each voice unfiltered into its own lane, then filters all of them together.
+void VoiceBank::renderGroup(const int* voices, int voiceCount, float* out, int frames) {
+    // Scratch space on the stack, deliberately left uninitialized.
+    AudioBuffer envelopeBuffer;
+    std::array<AudioBuffer, FILTER_LANES> lanes;
+    std::array<std::array<float, FRAMES_PER_BUFFER>, FILTER_LANES> cutoffs;
+    const auto modulated = _patch->modulationRouteCount > 0;
+
+    for (auto lane = 0; lane < voiceCount; ++lane) {
+        auto voice = voices[lane];
+        auto held = renderEnvelope(_envelopes[voice], _envelopeShape, _sampleRate, envelopeBuffer.data(), frames);
+        // Events split rendering, so a bend holds still for the whole of frames.
+        auto bend = bendCents(voice);
+        if (modulated) {
+            if (held) {
+                std::fill(envelopeBuffer.begin(), envelopeBuffer.begin() + frames, _envelopes[voice].level);
+            }
+            renderModulatedVoice(voice, bend, envelopeBuffer.data(), lanes[lane].data(), cutoffs[lane].data(), frames);
+        } else {
+            renderVoice(voice, bend, held ? nullptr : envelopeBuffer.data(), lanes[lane].data(), frames);
+        }
+    }
+    // The vector kernels work on whole sets of four lanes.
+    for (auto lane = voiceCount; lane < ((voiceCount + 3) & ~3); ++lane) {
+        std::fill(lanes[lane].begin(), lanes[lane].begin() + frames, 0.0f);
+    }
+
+    filterGroup(voices, voiceCount, lanes[0].data(), modulated ? cutoffs[0].data() : nullptr, out, frames);
+}
+
+void VoiceBank::renderVoice(int voice, float bend, const float* envelope, float* out, int frames) {
+    const auto& waveTable = *_patch->waveTable;
+    const auto increment = bendPhaseIncrement(_phaseIncrements[voice], bend);
+    _phases[voice] = _oscillatorKernel(waveTable.level(increment).data(), _phases[voice], increment, out, frames);
+
+    const auto gain = _gains[voice];
+    if (!envelope) {
+        const auto level = _envelopes[voice].level * gain;
+        for (auto frame = 0; frame < frames; ++frame) {
+            out[frame] *= level;
+        }
+        return;
+    }
+    for (auto frame = 0; frame < frames; ++frame) {
+        out[frame] *= envelope[frame] * gain;
+    }
+}
+
+// Modulation is worked out once per control period. Pitch steps from one period to the
+// next, with the phase kept continuous, and amplitude ramps linearly so it doesn't zip.
+// The cutoff each period asks for is written to cutoffs for the filter to glide towards.
+void VoiceBank::renderModulatedVoice(int voice, float bend, const float* envelope, float* out, float* cutoffs, int frames) {
+    const auto& waveTable = *_patch->waveTable;
+    const auto gain = _gains[voice];
+    const auto pressure = _channelPressures[_channels[voice]];
+    const auto timbre = _channelTimbres[_channels[voice]];
+    auto phase = _phases[voice];
+    auto amplitude = _amplitudeModulations[voice];
+
+    auto tick = 0;
+    for (auto start = 0; start < frames; start += _controlRate, ++tick) {
+        auto periodFrames = std::min(_controlRate, frames - start);
+        const float sources[] = {_lfoValues[0][tick], _lfoValues[1][tick], envelope[start + periodFrames - 1], pressure, timbre};
+
+        auto pitch = 0.0f;
+        auto targetAmplitude = 1.0f;
+        auto cutoff = _baseFilterCutoff;
+        for (auto route = 0; route < _patch->modulationRouteCount; ++route) {
+            const auto& modulationRoute = _patch->modulationRoutes[route];
+            auto amount = static_cast<float>(modulationRoute.depth) * sources[static_cast<int>(modulationRoute.source)];
+            switch (modulationRoute.destination) {
+            case ModulationDestination::Pitch:
+                pitch += amount;
+                break;
+            case ModulationDestination::Amplitude:
+                targetAmplitude += amount;
+                break;
+            case ModulationDestination::FilterCutoff:
+                cutoff += amount;
+                break;
+            }
+        }
+        targetAmplitude = std::max(targetAmplitude, 0.0f);
+        cutoffs[tick] = cutoff;
+
+        auto increment = bendPhaseIncrement(_phaseIncrements[voice], bend + pitch * 100.0f);
+        phase = _oscillatorKernel(waveTable.level(increment).data(), phase, increment, out + start, periodFrames);
+
+        const auto amplitudeStep = (targetAmplitude - amplitude) / periodFrames;
+        for (auto frame = start; frame < start + periodFrames; ++frame) {
+            amplitude += amplitudeStep;
+            out[frame] *= envelope[frame] * gain * amplitude;
+        }
+        amplitude = targetAmplitude;
+    }
+
+    _phases[voice] = phase;
+    _amplitudeModulations[voice] = amplitude;
+}
+
+// in holds one lane of FRAMES_PER_BUFFER samples per voice, and cutoffs one target per
+// control period per voice, or null to hold every voice at the patch's cutoff. Settled
+// voices run through the kernel in one go; gliding ones a control period at a time.
+void VoiceBank::filterGroup(const int* voices, int voiceCount, const float* in, const float* cutoffs, float* out, int frames) {
+    // Lanes past voiceCount stay silent.
+    FilterLanes lanes{};
+    auto settled = cutoffs == nullptr;
+    for (auto lane = 0; lane < voiceCount; ++lane) {
+        auto voice = voices[lane];
+        lanes.s1[lane] = _filterStates[voice].s1;
+        lanes.s2[lane] = _filterStates[voice].s2;
+        settled = settled && _filterCutoffs[voice] == _baseFilterCutoff;
+    }
+
+    auto tick = 0;
+    auto periodFrames = settled ? frames : _controlRate;
+    for (auto start = 0; start < frames; start += periodFrames, ++tick) {
+        // Voices that follow the same LFO glide into step, so they can share coefficients.
+        auto sharedCutoff = _baseFilterCutoff;
+        auto sharedCoefficients = _baseFilterCoefficients;
+        for (auto lane = 0; lane < voiceCount; ++lane) {
+            auto voice = voices[lane];
+            updateFilterCoefficients(voice,
+                                     cutoffs ? cutoffs[lane * FRAMES_PER_BUFFER + tick] : _baseFilterCutoff,
+                                     sharedCutoff,
+                                     sharedCoefficients);
+            for (auto i = 0; i < FILTER_COEFFICIENT_COUNT; ++i) {
+                lanes.coefficients[i][lane] = _filterCoefficients[voice][i];
+            }
+        }
+        _filterKernel(lanes, voiceCount, in + start, FRAMES_PER_BUFFER, out + start, std::min(periodFrames, frames - start));
+    }
+
+    for (auto lane = 0; lane < voiceCount; ++lane) {
+        _filterStates[voices[lane]] = FilterState{lanes.s1[lane], lanes.s2[lane]};
+    }
+}
+
+// Moves the voice's cutoff one control period closer to target, and recomputes its
+// coefficients only if that changed anything and they aren't the shared ones. Whatever
+// gets computed becomes the shared coefficients for the next voice.
+void VoiceBank::updateFilterCoefficients(int voice, float target, float& sharedCutoff, FilterCoefficients& sharedCoefficients) {
+    auto& cutoff = _filterCutoffs[voice];
+    auto distance = target - cutoff;
+    cutoff = std::abs(distance) < FILTER_CUTOFF_SNAP ? target : cutoff + distance * _filterCutoffSmoothing;
+    if (cutoff == _filterCoefficientCutoffs[voice]) {
+        return;
+    }
+
+    if (cutoff != sharedCutoff) {
+        sharedCutoff = cutoff;
+        sharedCoefficients = filterCoefficients(_filterMode, _filterTopology, std::exp2(cutoff), _filterResonance, _sampleRate);
+    }
+    _filterCoefficients[voice] = sharedCoefficients;
+    _filterCoefficientCutoffs[voice] = cutoff;
+}
+
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <microtone/midi_input.hpp>
+#include <microtone/synthesizer/audio_buffer.hpp>
+#include <microtone/synthesizer/envelope.hpp>
+#include <microtone/synthesizer/low_frequency_oscillator.hpp>
+#include <microtone/synthesizer/modulation.hpp>
+#include <microtone/synthesizer/oscillator_kernel.hpp>
+#include <microtone/synthesizer/polyphony.hpp>
+
+#include <synthesizer/envelope_generator.hpp>
+#include <synthesizer/filter_bank.hpp>
+#include <synthesizer/patch.hpp>
+
+#include <array>
+
+namespace microtone {
+
+const int MAX_VOICES = MAX_POLYPHONY;
+
+// Renders every voice of the synthesizer in one pass. Voice state is kept as a
+// struct of arrays so that the render loop walks contiguous, cache-line aligned
+// memory instead of chasing a pimpl per oscillator, envelope and filter. Voices are
+// filtered FILTER_LANES at a time, one per SIMD lane.
+class VoiceBank {
+public:
+    explicit VoiceBank(double sampleRate);
+
+    // The patch must stay valid until it's replaced; the audio thread sets it every block.
+    void setPatch(const Patch* patch);
+
+    // Pitched by the patch's tuning, which sounding voices follow when it changes. The voice
+    // follows the expression of channel until it's next started.
+    void noteOn(int voice, int channel, int note, int velocity);
+    void noteOff(int voice);
+    // Whether the patch's tuning gives the note a pitch at all.
+    bool isMapped(int note) const;
+    bool isActive(int voice) const;
+    // The envelope level scaled by velocity.
+    float level(int voice) const;
+
+    // Expression per MIDI channel, applied to every voice playing on it from the next
+    // render. bend is -1 to 1, a full bend by the patch's pitch bend range. pressure and
+    // timbre are 0 to 1 and reach voices as modulation sources.
+    void setPitchBend(int channel, float bend);
+    void setPressure(int channel, float pressure);
+    void setTimbre(int channel, float timbre);
+
+    // Every voice that's sounding, packed at the front of an array. Voices that finish while
+    // rendering stay listed until retireFinishedVoices().
+    const int* activeVoices() const;
+    int activeVoiceCount() const;
+    // Drops voices that have finished their release from the active list, writes them to
+    // retired and returns how many there were. Call between renders, never during one.
+    int retireFinishedVoices(int* retired);
+
+    // Adds every active voice into out.
+    void render(float* out, int frames);
+
+    // Evaluates the LFOs at control rate for the next frames, at most FRAMES_PER_BUFFER,
+    // and moves them on. Call once before rendering those frames.
+    void prepareModulation(int frames);
+    // Adds the given voices into out, over the frames passed to prepareModulation().
+    // Distinct voices can be rendered on different threads.
+    void render(const int* voices, int voiceCount, float* out, int frames);
+
+private:
+    void retune();
+    float bendCents(int voice) const;
+    void renderGroup(const int* voices, int voiceCount, float* out, int frames);
+    // A null envelope holds at the voice's envelope level.
+    void renderVoice(int voice, float bend, const float* envelope, float* out, int frames);
+    void renderModulatedVoice(int voice, float bend, const float* envelope, float* out, float* cutoffs, int frames);
+    void filterGroup(const int* voices, int voiceCount, const float* in, const float* cutoffs, float* out, int frames);
+    void updateFilterCoefficients(int voice, float target, float& sharedCutoff, FilterCoefficients& sharedCoefficients);
+
+    double _sampleRate;
+    const Patch* _patch;
+    // The tuning voices were last pitched from. The current patch keeps it alive, so a
+    // different pointer always means a different tuning.
+    const TuningTable* _tuning;
+    OscillatorKernelFn _oscillatorKernel;
+    std::array<LowFrequencyOscillator, LFO_COUNT> _lfos;
+    EnvelopeShape _envelopeShape;
+    int _controlRate;
+    // LFO values at the end of each control period of the prepared frames, which voices ramp
+    // towards over the period. A period is at least one frame, so a buffer has at most
+    // FRAMES_PER_BUFFER of them.
+    std::array<std::array<float, FRAMES_PER_BUFFER>, LFO_COUNT> _lfoValues;
+    std::array<float, MIDI_CHANNEL_COUNT> _channelBends;
+    std::array<float, MIDI_CHANNEL_COUNT> _channelPressures;
+    std::array<float, MIDI_CHANNEL_COUNT> _channelTimbres;
+
+    // The patch's filter, with coefficients worked out for its cutoff only when it changes.
+    // Cutoffs are kept as log2 of hertz, so modulation in octaves just adds.
+    FilterMode _filterMode;
+    FilterTopology _filterTopology;
+    double _filterResonance;
+    float _baseFilterCutoff;
+    FilterCoefficients _baseFilterCoefficients;
+    FilterBankKernelFn _filterKernel;
+    float _filterCutoffSmoothing;                           // How far a cutoff glides towards its target per control period.
+
+    int _activeVoiceCount;
+    std::array<int, MAX_VOICES> _activeVoices;
+    std::array<int, MAX_VOICES> _activeVoicePositions;     // Index into _activeVoices, -1 when off.
+
+    alignas(64) std::array<int, MAX_VOICES> _notes;
+    alignas(64) std::array<int, MAX_VOICES> _channels;
+    alignas(64) std::array<OscillatorPhase, MAX_VOICES> _phases;
+    alignas(64) std::array<OscillatorPhase, MAX_VOICES> _phaseIncrements;     // Unbent, straight from the tuning.
+    alignas(64) std::array<float, MAX_VOICES> _gains;
+    alignas(64) std::array<EnvelopeGenerator, MAX_VOICES> _envelopes;
+    alignas(64) std::array<FilterState, MAX_VOICES> _filterStates;
+    alignas(64) std::array<float, MAX_VOICES> _filterCutoffs;
+    alignas(64) std::array<float, MAX_VOICES> _filterCoefficientCutoffs;   // What _filterCoefficients were worked out for, NaN when stale.
+    alignas(64) std::array<FilterCoefficients, MAX_VOICES> _filterCoefficients;
+    // Where the last control period left off, so the next one ramps from there.
+    alignas(64) std::array<float, MAX_VOICES> _amplitudeModulations;
+};
+
+}
@@ -0,0 +1,56 @@
+TEMPLATE = app
+TARGET = microtone_stress
+CONFIG += \
+    console \
+    c++17
+
+CONFIG -= qt gui
+
+DEFINES += \
+    FMT_HEADER_ONLY
+
+macx {
+DEFINES += __MACOSX_CORE__
+}
+windows {
+DEFINES += __WINDOWS_MM__
+}
+
+SOURCES += \
+  main.cpp
+
+INCLUDEPATH += \
+  $$PWD/../Microtone/include \
+  $$PWD/../vendor/fmt-8.0.1/include
+
+DEPENDPATH += \
+  $$PWD/../Microtone/include \
+  $$PWD/../vendor/fmt-8.0.1/include
+
+macx {
+LIBS += \
+    -L$$OUT_PWD/../Microtone -lMicrotone \
+    -L$$PWD/../Microtone/vendor/rtmidi-5.0.0/lib/macos -lrtmidi \
+    -L$$PWD/../Microtone/vendor/portaudio-19.7.0/lib/macos -lportaudio \
+    -framework AudioToolbox \
+    -framework Carbon \
+    -framework CoreAudio \
+    -framework CoreFoundation \
+    -framework CoreServices \
+    -framework CoreMIDI
+}
+
+win32 {
+
+#RELEASE / DEBUG
+CONFIG(debug, debug|release) {
+    DEST_DIR = debug
+} else {
+    DEST_DIR = release
+}
+
+LIBS += \
+    -L$$OUT_PWD/../Microtone/$$DEST_DIR/ -lMicrotone \
+    -L$$PWD/../Microtone/vendor/rtmidi-5.0.0/lib/windows -lrtmidi \
+    -L$$PWD/../Microtone/vendor/portaudio-19.7.0/lib/windows -lportaudio_x64
+}
@@ -0,0 +1,337 @@
+#include <microtone/audio_backend.hpp>
+#include <microtone/microtone_platform.hpp>
+#include <microtone/midi_input.hpp>
+#include <microtone/synthesizer/envelope.hpp>
+#include <microtone/synthesizer/polyphony.hpp>
+#include <microtone/synthesizer/synthesizer.hpp>
+#include <microtone/synthesizer/weighted_wavetable.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Voices need a moment to pile up to the polyphony limit before renders count.
+const double WARM_UP_SECONDS = 0.5;
+// Long enough that every note on keeps a voice busy until it's stolen.
+const double RELEASE_SECONDS = 4.0;
+// Leaves room in the synthesizer's event queue for the notes of a chord change.
+const int MAX_CONTROL_CHANGES_PER_BUFFER = 512;
+
+const int NOTE_ON = 0b10010000;
+const int NOTE_OFF = 0b10000000;
+const int CONTROL_CHANGE = 0b10110000;
+const int SUSTAIN_PEDAL = 64;
+
+enum class Load {
+    Chords = 0,         // Every chord note changes ten times a second.
+    Sustain,            // Fast runs under a sustain pedal that's only lifted now and then.
+    Repeats,            // A few notes retriggered every 5ms, each leaving a release tail.
+    ControlStorm        // Chords under a flood of random controller messages.
+};
+
+const std::vector<std::pair<Load, std::string>> LOADS{{Load::Chords, "chords"},
+                                                      {Load::Sustain, "sustain"},
+                                                      {Load::Repeats, "repeats"},
+                                                      {Load::ControlStorm, "cc-storm"}};
+
+struct Options {
+    double sampleRate = 48000;
+    int bufferFrames = 256;
+    int renderThreads = 1;
+    double seconds = 2.0;
+    double percentile = 99.0;
+    bool paced = true;
+    bool help = false;
+    std::vector<Load> loads{Load::Chords, Load::Sustain, Load::Repeats, Load::ControlStorm};
+};
+
+struct Trial {
+    bool passed;
+    double renderTimeShare;    // The percentile render time over the deadline.
+    int minActiveVoices;
+};
+
+std::vector<microtone::WeightedWaveTable> makeWaveTables() {
+    auto sineWave = microtone::WaveTable{};
+    auto sawWave = microtone::WaveTable{};
+    for (auto i = 0; i < microtone::WAVETABLE_LENGTH; ++i) {
+        sineWave[i] = std::sin(2.0 * M_PI * i / microtone::WAVETABLE_LENGTH);
+        sawWave[i] = 2.0f * i / microtone::WAVETABLE_LENGTH - 1.0f;
+    }
+    return {{sineWave, 0.6}, {sawWave, 0.4}};
+}
+
+// Sends one load's MIDI to the synthesizer a buffer at a time. Events land at the start of
+// the buffer they're sent for.
+class LoadGenerator {
+public:
+    LoadGenerator(Load load, int voices, double sampleRate) :
+        _load{load},
+        _chordSize{std::min(voices, microtone::MIDI_NOTE_COUNT)},
+        _sampleRate{sampleRate},
+        _chordRoot{0},
+        _nextNote{0},
+        _random{} {
+    }
+
+    void emit(microtone::Synthesizer& synth, std::int64_t frame, int frames) {
+        auto send = [&](int status, int note, int velocity) {
+            synth.addMidiData(status, note, velocity, 0);
+        };
+
+        switch (_load) {
+        case Load::Chords:
+            emitChords(send, frame, frames);
+            break;
+        case Load::Sustain:
+            if (ticks(0.5, frame, frames) > 0) {
+                send(CONTROL_CHANGE, SUSTAIN_PEDAL, 0);
+                send(CONTROL_CHANGE, SUSTAIN_PEDAL, 127);
+            }
+            for (auto i = ticks(1000.0, frame, frames); i > 0; --i) {
+                send(NOTE_ON, _nextNote, 100);
+                send(NOTE_OFF, _nextNote, 0);
+                _nextNote = (_nextNote + 5) % microtone::MIDI_NOTE_COUNT;
+            }
+            break;
+        case Load::Repeats:
+            if (ticks(200.0, frame, frames) > 0) {
+                for (auto note = 60; note < 68; ++note) {
+                    send(NOTE_ON, note, 100);
+                }
+            }
+            break;
+        case Load::ControlStorm:
+            emitChords(send, frame, frames);
+            for (auto i = std::min(ticks(20000.0, frame, frames), MAX_CONTROL_CHANGES_PER_BUFFER); i > 0; --i) {
+                send(CONTROL_CHANGE, static_cast<int>(_random() % 128), static_cast<int>(_random() % 128));
+            }
+            break;
+        }
+    }
+
+private:
+    template <typename SendFn>
+    void emitChords(SendFn& send, std::int64_t frame, int frames) {
+        if (ticks(10.0, frame, frames) == 0) {
+            return;
+        }
+        for (auto i = 0; i < _chordSize; ++i) {
+            send(NOTE_OFF, (_chordRoot + i) % microtone::MIDI_NOTE_COUNT, 0);
+        }
+        _chordRoot = (_chordRoot + 7) % microtone::MIDI_NOTE_COUNT;
+        for (auto i = 0; i < _chordSize; ++i) {
+            send(NOTE_ON, (_chordRoot + i) % microtone::MIDI_NOTE_COUNT, 100);
+        }
+    }
+
+    // How many events of something that happens perSecond times a second fall into the
+    // buffer, the first one on frame 0.
+    int ticks(double perSecond, std::int64_t frame, int frames) const {
+        auto count = [&](std::int64_t at) {
+            return static_cast<std::int64_t>(std::ceil(at * perSecond / _sampleRate));
+        };
+        return static_cast<int>(count(frame + frames) - count(frame));
+    }
+
+    Load _load;
+    int _chordSize;
+    double _sampleRate;
+    int _chordRoot;
+    int _nextNote;
+    std::minstd_rand _random;
+};
+
+// Renders options.seconds of load at the given polyphony and checks the render time
+// percentile against the buffer's deadline.
+Trial runTrial(const Options& options, const std::vector<microtone::WeightedWaveTable>& waveTables, Load load, int voices) {
+    auto synth = microtone::Synthesizer{waveTables,
+                                        std::make_unique<microtone::OfflineAudioBackend>(options.sampleRate),
+                                        options.renderThreads};
+    synth.setPolyphony(voices);
+    synth.setEnvelope(microtone::Envelope{0.005, 0.1, 0.8, RELEASE_SECONDS, options.sampleRate});
+
+    auto generator = LoadGenerator{load, voices, options.sampleRate};
+    auto buffer = std::vector<float>(static_cast<std::size_t>(options.bufferFrames));
+    auto deadline = std::chrono::duration<double>(options.bufferFrames / options.sampleRate);
+    auto warmUpBuffers = static_cast<int>(WARM_UP_SECONDS * options.sampleRate / options.bufferFrames);
+    auto buffers = warmUpBuffers + static_cast<int>(options.seconds * options.sampleRate / options.bufferFrames);
+
+    auto renderTimes = std::vector<double>{};
+    renderTimes.reserve(static_cast<std::size_t>(buffers));
+    auto minActiveVoices = voices;
+    auto start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < buffers; ++i) {
+        // Rendering back to back keeps caches and render threads warmer than a real
+        // callback would find them, so by default buffers come at the device's pace.
+        if (options.paced) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(deadline * i));
+        }
+
+        generator.emit(synth, static_cast<std::int64_t>(i) * options.bufferFrames, options.bufferFrames);
+        auto renderStart = std::chrono::steady_clock::now();
+        synth.render(buffer.data(), buffer.size());
+        auto renderTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - renderStart);
+
+        if (i >= warmUpBuffers) {
+            renderTimes.push_back(renderTime / deadline);
+            minActiveVoices = std::min(minActiveVoices, synth.metrics().activeVoices);
+        }
+    }
+
+    auto rank = static_cast<std::size_t>(std::ceil(options.percentile / 100.0 * renderTimes.size()));
+    rank = std::clamp(rank, std::size_t{1}, renderTimes.size()) - 1;
+    std::nth_element(renderTimes.begin(), renderTimes.begin() + rank, renderTimes.end());
+    auto share = renderTimes[rank];
+    return Trial{share <= 1.0, share, minActiveVoices};
+}
+
+// The most voices that pass, assuming every count below a passing one passes too.
+void searchCapacity(const Options& options, const std::vector<microtone::WeightedWaveTable>& waveTables, Load load, const std::string& name) {
+    auto low = 0;
+    auto high = microtone::MAX_POLYPHONY;
+    auto best = Trial{false, 0.0, 0};
+    // Fast machines pass at the limit, which takes a single trial to find out.
+    auto voices = high;
+    while (low < high) {
+        auto trial = runTrial(options, waveTables, load, voices);
+        std::cout << fmt::format("{:>10} {:>8} voices  {:>6.1f}% of deadline  {}",
+                                 name,
+                                 voices,
+                                 trial.renderTimeShare * 100.0,
+                                 trial.passed ? "ok" : "too slow")
+                  << std::endl;
+        if (trial.passed) {
+            low = voices;
+            best = trial;
+        } else {
+            high = voices - 1;
+        }
+        voices = (low + high + 1) / 2;
+    }
+
+    if (low == 0) {
+        std::cout << fmt::format("{:>10}: can't render a single voice within the deadline", name) << std::endl;
+    } else {
+        std::cout << fmt::format("{:>10}: {} voices{}{}",
+                                 name,
+                                 low,
+                                 low == microtone::MAX_POLYPHONY ? " (MAX_POLYPHONY, the real limit is higher)" : "",
+                                 best.minActiveVoices < low ? fmt::format(", though the load only kept {} sounding", best.minActiveVoices) : "")
+                  << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void printUsage() {
+    std::cout << "Usage: microtone_stress [options]\n"
+                 "Finds the most voices the synthesizer renders within the deadline under synthetic MIDI loads.\n"
+                 "  --sample-rate <hz>     default 48000\n"
+                 "  --buffer <frames>      default 256\n"
+                 "  --threads <count>      render threads, counting the audio thread, default 1\n"
+                 "  --seconds <seconds>    measured per trial, default 2\n"
+                 "  --percentile <p>       render time percentile that must meet the deadline, default 99\n"
+                 "  --load <name>          chords, sustain, repeats or cc-storm, default all of them\n"
+                 "  --unpaced              render back to back instead of at the device's pace\n"
+                 "  -h, --help             print this and exit"
+              << std::endl;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    auto loadsGiven = false;
+    for (auto i = 1; i < argc; ++i) {
+        auto arg = std::string{argv[i]};
+        if (arg == "--unpaced") {
+            options.paced = false;
+            continue;
+        }
+        if (arg == "--help" || arg == "-h") {
+            options.help = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+
+        auto value = std::string{argv[++i]};
+        try {
+            if (arg == "--sample-rate") {
+                options.sampleRate = std::stod(value);
+            } else if (arg == "--buffer") {
+                options.bufferFrames = std::stoi(value);
+            } else if (arg == "--threads") {
+                options.renderThreads = std::stoi(value);
+            } else if (arg == "--seconds") {
+                options.seconds = std::stod(value);
+            } else if (arg == "--percentile") {
+                options.percentile = std::stod(value);
+            } else if (arg == "--load") {
+                auto load = std::find_if(LOADS.begin(), LOADS.end(), [&](const auto& entry) {
+                    return entry.second == value;
+                });
+                if (load == LOADS.end()) {
+                    return false;
+                }
+                if (!loadsGiven) {
+                    options.loads.clear();
+                    loadsGiven = true;
+                }
+                options.loads.push_back(load->first);
+            } else {
+                return false;
+            }
+        } catch (const std::logic_error&) {
+            return false;
+        }
+    }
+
+    return options.sampleRate > 0 && options.bufferFrames > 0 && options.renderThreads > 0 &&
+           options.seconds > 0 && options.percentile > 0 && options.percentile <= 100;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    microtone::Platform::init();
+
+    auto options = Options{};
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+    if (options.help) {
+        printUsage();
+        return 0;
+    }
+
+    std::cout << fmt::format("{} Hz, {} frame buffers ({:.2f}ms deadline), {} render thread{}, {}th percentile{}",
+                             options.sampleRate,
+                             options.bufferFrames,
+                             options.bufferFrames / options.sampleRate * 1000.0,
+                             options.renderThreads,
+                             options.renderThreads == 1 ? "" : "s",
+                             options.percentile,
+                             options.paced ? "" : ", unpaced")
+              << std::endl
+              << std::endl;
+
+    auto waveTables = makeWaveTables();
+    for (auto load : options.loads) {
+        auto name = std::find_if(LOADS.begin(), LOADS.end(), [&](const auto& entry) {
+                        return entry.first == load;
+                    })->second;
+        searchCapacity(options, waveTables, load, name);
+    }
+
+    return 0;
+}
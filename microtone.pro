@@ -3,8 +3,15 @@ CONFIG += ordered
 
 SUBDIRS += \
     Microtone \
-    Asciiboard
+    Asciiboard \
+    Benchmark \
+    Stress
 
 Asciiboard.depends = \
     Microtone
 
+Benchmark.depends = \
+    Microtone
+
+Stress.depends = \
+    Microtone